@@ -63,6 +63,17 @@ class LengthHeaderCodec : boost::noncopyable
     conn->send(&buf);   //把muduo::string封装成muduo::Buffer后发送
   }
 
+  // 只打包一次，发给多个连接时共享同一份数据
+  static muduo::net::SharedStringPtr encode(const muduo::StringPiece& message)
+  {
+    muduo::net::Buffer buf;
+    buf.append(message.data(), message.size());
+    int32_t len = static_cast<int32_t>(message.size());
+    int32_t be32 = muduo::net::sockets::hostToNetwork32(len);
+    buf.prepend(&be32, sizeof be32);
+    return muduo::net::SharedStringPtr(new muduo::string(buf.retrieveAllAsString()));
+  }
+
  private:
   StringMessageCallback messageCallback_;
   const static size_t kHeaderLen = sizeof(int32_t);
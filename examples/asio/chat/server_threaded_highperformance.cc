@@ -61,7 +61,8 @@ class ChatServer : boost::noncopyable
                        const string& message,
                        Timestamp)
   {
-    EventLoop::Functor f = boost::bind(&ChatServer::distributeMessage, this, message);
+    SharedStringPtr encoded(LengthHeaderCodec::encode(message));  //只打包一次，各IO线程共享
+    EventLoop::Functor f = boost::bind(&ChatServer::distributeMessage, this, encoded);
     LOG_DEBUG;
 
     MutexLockGuard lock(mutex_);
@@ -76,14 +77,14 @@ class ChatServer : boost::noncopyable
 
   typedef std::set<TcpConnectionPtr> ConnectionList;
 
-  void distributeMessage(const string& message)
+  void distributeMessage(const SharedStringPtr& message)
   {
     LOG_DEBUG << "begin";
     for (ConnectionList::iterator it = LocalConnections::instance().begin();
         it != LocalConnections::instance().end();
         ++it)
     {
-      codec_.send(get_pointer(*it), message);
+      (*it)->send(message);
     }
     LOG_DEBUG << "end";
   }
@@ -46,7 +46,7 @@ class Topic : public muduo::copyable
   {
     content_ = content;
     lastPubTime_ = time;
-    string message = makeMessage();
+    SharedStringPtr message(new string(makeMessage())); //只生成一次，各连接共享，不拷贝
     for (std::set<TcpConnectionPtr>::iterator it = audiences_.begin();
          it != audiences_.end();
          ++it)
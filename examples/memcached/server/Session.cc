@@ -94,9 +94,10 @@ void Session::onMessage(const muduo::net::TcpConnectionPtr& conn,
       }
       else  // ASCII protocol
       {
-        const char* crlf = buf->findCRLF();
+        const char* crlf = buf->findCRLF(&lineScanned_);
         if (crlf)
         {
+          lineScanned_ = 0;
           int len = static_cast<int>(crlf - buf->peek());
           StringPiece request(buf->peek(), len);
           if (processRequest(request))
@@ -28,6 +28,7 @@ class Session : boost::noncopyable,
       noreply_(false),
       policy_(Item::kInvalid),
       bytesToDiscard_(0),
+      lineScanned_(0),
       needle_(Item::makeItem(kLongestKey, 0, 0, 2, 0)),
       bytesRead_(0),
       requestsProcessed_(0)
@@ -97,6 +98,7 @@ class Session : boost::noncopyable,
   Item::UpdatePolicy policy_;
   ItemPtr currItem_;
   size_t bytesToDiscard_;
+  size_t lineScanned_;  // see Buffer::findCRLF(size_t*)
   // cached
   ItemPtr needle_;
   muduo::net::Buffer outputBuf_;
@@ -3,12 +3,29 @@
 #include <muduo/net/TcpClient.h>
 #include <muduo/net/TcpServer.h>
 
+#include <boost/bind.hpp>
+
 #include <stdio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
 const size_t frameLen = 2*sizeof(int64_t);
+int busyPollUs = 0;  //忙轮询的空转时间，0表示不空转
+
+void printSpins(EventLoop* loop)
+{
+  LOG_INFO << "spins " << loop->spins() << " idle spins " << loop->idleSpins();
+}
+
+void setBusyPoll(EventLoop* loop)
+{
+  if (busyPollUs > 0)
+  {
+    loop->setBusyPoll(busyPollUs);
+    loop->runEvery(5.0, boost::bind(printSpins, loop));
+  }
+}
 
 void serverConnectionCallback(const TcpConnectionPtr& conn)
 {
@@ -41,6 +58,7 @@ void serverMessageCallback(const TcpConnectionPtr& conn,
 void runServer(uint16_t port)
 {
   EventLoop loop;
+  setBusyPoll(&loop);
   TcpServer server(&loop, InetAddress(port), "ClockServer");
   server.setConnectionCallback(serverConnectionCallback);
   server.setMessageCallback(serverMessageCallback);
@@ -97,6 +115,7 @@ void sendMyTime()
 void runClient(const char* ip, uint16_t port)
 {
   EventLoop loop;
+  setBusyPoll(&loop);
   TcpClient client(&loop, InetAddress(ip, port), "ClockClient");
   client.enableRetry();
   client.setConnectionCallback(clientConnectionCallback);
@@ -110,6 +129,10 @@ int main(int argc, char* argv[])
 {
   if (argc > 2)
   {
+    if (argc > 3)
+    {
+      busyPollUs = atoi(argv[3]);
+    }
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
     if (strcmp(argv[1], "-s") == 0)
     {
@@ -122,7 +145,7 @@ int main(int argc, char* argv[])
   }
   else
   {
-    printf("Usage:\n%s -s port\n%s ip port\n", argv[0], argv[0]);
+    printf("Usage:\n%s -s port [busy_poll_us]\n%s ip port [busy_poll_us]\n", argv[0], argv[0]);
   }
 }
 
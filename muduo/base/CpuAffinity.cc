@@ -0,0 +1,143 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/CpuAffinity.h>
+
+#include <muduo/base/FileUtil.h>
+#include <muduo/base/Logging.h>
+
+#include <sched.h>
+#include <stdio.h>  // snprintf
+#include <stdlib.h>
+
+using namespace muduo;
+
+CpuAffinity::CpuAffinity()
+  : perThread_(false)
+{
+}
+
+CpuAffinity CpuAffinity::cpuList(const std::vector<int>& cpus)
+{
+  CpuAffinity affinity;
+  affinity.cpus_ = cpus;
+  affinity.perThread_ = true;
+  return affinity;
+}
+
+CpuAffinity CpuAffinity::roundRobin()
+{
+  return cpuList(allowedCpus());
+}
+
+CpuAffinity CpuAffinity::sameNodeAs(const string& interface)
+{
+  CpuAffinity affinity;
+  int node = numaNodeOf(interface);
+  if (node >= 0)
+  {
+    affinity.cpus_ = cpusOfNode(node);
+  }
+  if (affinity.cpus_.empty())
+  {
+    LOG_WARN << "CpuAffinity::sameNodeAs - NUMA node of " << interface
+             << " is unknown, threads are not pinned";
+  }
+  return affinity;
+}
+
+std::vector<int> CpuAffinity::cpusOf(int index) const
+{
+  if (!perThread_ || cpus_.empty())
+  {
+    return cpus_;
+  }
+  return std::vector<int>(1, cpus_[index % cpus_.size()]);
+}
+
+int CpuAffinity::numaNodeOf(const string& interface)
+{
+  string content;
+  string filename = "/sys/class/net/" + interface + "/device/numa_node";
+  if (FileUtil::readFile(filename, 64, &content) != 0 || content.empty())
+  {
+    return -1;
+  }
+  return atoi(content.c_str());  //没有NUMA的机器上是-1
+}
+
+std::vector<int> CpuAffinity::cpusOfNode(int node)
+{
+  char filename[64];
+  snprintf(filename, sizeof filename, "/sys/devices/system/node/node%d/cpulist", node);
+  string content;
+  if (FileUtil::readFile(filename, 4096, &content) != 0)
+  {
+    return std::vector<int>();
+  }
+  return parseCpuList(content);
+}
+
+std::vector<int> CpuAffinity::allowedCpus()
+{
+  std::vector<int> cpus;
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if (::sched_getaffinity(0, sizeof cpuset, &cpuset) == 0)
+  {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &cpuset))
+      {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+  return cpus;
+}
+
+std::vector<int> CpuAffinity::parseCpuList(const string& list)
+{
+  std::vector<int> cpus;
+  const char* p = list.c_str();
+  const char* end = p + list.size();
+  while (p < end && *p != '\n')
+  {
+    char* next = NULL;
+    long first = strtol(p, &next, 10);
+    if (next == p || first < 0)
+    {
+      return std::vector<int>();
+    }
+    long last = first;
+    p = next;
+    if (p < end && *p == '-')
+    {
+      ++p;
+      last = strtol(p, &next, 10);
+      if (next == p || last < first)
+      {
+        return std::vector<int>();
+      }
+      p = next;
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+    {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    if (p < end && *p == ',')
+    {
+      ++p;
+    }
+    else if (p < end && *p != '\n')
+    {
+      return std::vector<int>();
+    }
+  }
+  return cpus;
+}
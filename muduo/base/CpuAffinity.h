@@ -0,0 +1,64 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_BASE_CPUAFFINITY_H
+#define MUDUO_BASE_CPUAFFINITY_H
+
+#include <muduo/base/copyable.h>
+#include <muduo/base/Types.h>
+
+#include <vector>
+
+namespace muduo
+{
+
+///
+/// Where the threads of a pool run, see ThreadPool::setCpuAffinity()
+/// and EventLoopThreadPool::setCpuAffinity().
+///
+/// 线程在启动时、运行线程函数之前就绑定好CPU，
+/// Linux默认按first touch分配物理页，之后该线程创建的EventLoop、Buffer等都落在本地NUMA节点上
+class CpuAffinity : public muduo::copyable
+{
+ public:
+  /// No pinning, the default.
+  CpuAffinity();
+
+  /// The i-th thread runs on cpus[i % cpus.size()].
+  static CpuAffinity cpuList(const std::vector<int>& cpus);
+  /// The i-th thread runs on the i-th CPU this process may use, wrapping around.
+  static CpuAffinity roundRobin();
+  /// All threads run on the CPUs of the NUMA node the network interface is attached to.
+  /// No pinning if the node is unknown, eg. virtual interfaces or non-NUMA machines.
+  static CpuAffinity sameNodeAs(const string& interface);
+
+  bool pinned() const { return !cpus_.empty(); }
+
+  /// CPUs for the @c index-th thread of a pool, empty for no pinning.
+  std::vector<int> cpusOf(int index) const;
+
+  // helpers, read sysfs
+
+  /// -1 if unknown.
+  static int numaNodeOf(const string& interface);
+  static std::vector<int> cpusOfNode(int node);
+  /// CPUs in the affinity mask of this process.
+  static std::vector<int> allowedCpus();
+  /// Parses the "0-3,8,10-11" format of sysfs cpulist, empty on error.
+  static std::vector<int> parseCpuList(const string& list);
+
+ private:
+  std::vector<int> cpus_;
+  bool perThread_;  //每个线程一个CPU，否则所有线程共用cpus_
+};
+
+}
+
+#endif  // MUDUO_BASE_CPUAFFINITY_H
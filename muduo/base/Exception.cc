@@ -43,16 +43,23 @@ void Exception::fillStackTrace()
   const int len = 200;
   void* buffer[len]; //指针数组，来保存地址，最多保存len个
   int nptrs = ::backtrace(buffer, len);//将栈回溯信息（函数地址）保存到buffer当中
-  char** strings = ::backtrace_symbols(buffer, nptrs);//将地址转换为函数名称（字符串要*,而指向多个字符串所以再*,因此**）
+  stack_ = symbolize(buffer, nptrs);
+}
+
+string Exception::symbolize(void* const* frames, int count)
+{
+  string stack;
+  char** strings = ::backtrace_symbols(frames, count);//将地址转换为函数名称（字符串要*,而指向多个字符串所以再*,因此**）
   if (strings)
   {
-    for (int i = 0; i < nptrs; ++i)
+    for (int i = 0; i < count; ++i)
     {
       // TODO demangle funcion name with abi::__cxa_demangle
-      stack_.append(strings[i]);//依次把函数名称信息添加到stack
-      stack_.push_back('\n');
+      stack.append(strings[i]);//依次把函数名称信息添加到stack
+      stack.push_back('\n');
     }
     free(strings); //因为实际是通过malloc函数开辟的内存，因此用完要释放
   }
+  return stack;
 }
 
@@ -23,6 +23,10 @@ class Exception : public std::exception
   virtual const char* what() const throw();
   const char* stackTrace() const throw();
 
+  /// Symbolizes frames from ::backtrace(), one per line.
+  /// Also used for stacks captured in signal handlers, see LoopWatchdog.
+  static string symbolize(void* const* frames, int count);
+
  private:
   void fillStackTrace();//获取栈信息
 
@@ -0,0 +1,297 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_INPLACEFUNCTION_H
+#define MUDUO_BASE_INPLACEFUNCTION_H
+
+#include <boost/function.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <new>
+#include <typeinfo>
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+#include <utility>
+#endif
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace muduo
+{
+
+///
+/// A void() callable like boost::function<void()>, stores small functors inline.
+///
+/// boost::function只有很小的函数对象才不分配内存，boost::bind绑定一个
+/// shared_ptr加一个string就要在堆上分配。这里的函数对象不超过kInlineSize字节
+/// 时就地存放，复制时也不分配内存；更大的才放到堆上。
+/// 用于EventLoop::Functor、TimerCallback和ThreadPool::Task。
+class InplaceFunction
+{
+ public:
+  /// Fits boost::bind(&Foo::bar, this, shared_ptr, string) with room to spare.
+  static const size_t kInlineSize = 96;
+
+  InplaceFunction()
+    : manager_(NULL)
+  {
+  }
+
+  template<typename F>
+  InplaceFunction(F f)  // implicit, like boost::function
+    : manager_(NULL)
+  {
+    assign(f);  //f已经是副本，C++11下搬进storage_，不再复制一次
+  }
+
+  InplaceFunction(const InplaceFunction& rhs)
+    : manager_(NULL)
+  {
+    if (rhs.manager_)
+    {
+      rhs.manager_->clone(&rhs.storage_, &storage_);
+      manager_ = rhs.manager_;
+    }
+  }
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+  InplaceFunction(InplaceFunction&& rhs)
+    : manager_(NULL)
+  {
+    moveFrom(rhs);
+  }
+
+  InplaceFunction& operator=(InplaceFunction&& rhs)
+  {
+    if (this != &rhs)
+    {
+      clear();
+      moveFrom(rhs);
+    }
+    return *this;
+  }
+#endif
+
+  ~InplaceFunction()
+  {
+    clear();
+  }
+
+  InplaceFunction& operator=(const InplaceFunction& rhs)
+  {
+    if (this != &rhs)
+    {
+      clear();
+      if (rhs.manager_)
+      {
+        rhs.manager_->clone(&rhs.storage_, &storage_);
+        manager_ = rhs.manager_;
+      }
+    }
+    return *this;
+  }
+
+  template<typename F>
+  InplaceFunction& operator=(F f)
+  {
+    clear();
+    assign(f);
+    return *this;
+  }
+
+  //堆上的函数对象只交换指针，就地存放的各搬移一次
+  void swap(InplaceFunction& rhs)
+  {
+    if (this == &rhs)
+    {
+      return;
+    }
+    Storage tmp;
+    const Manager* m = manager_;
+    if (m)
+    {
+      m->move(&storage_, &tmp);
+    }
+    manager_ = NULL;
+    moveFrom(rhs);
+    if (m)
+    {
+      m->move(&tmp, &rhs.storage_);
+      rhs.manager_ = m;
+    }
+  }
+
+  void clear()
+  {
+    if (manager_)
+    {
+      manager_->destroy(&storage_);
+      manager_ = NULL;
+    }
+  }
+
+  bool empty() const { return manager_ == NULL; }
+
+  typedef bool (InplaceFunction::*unspecified_bool_type)() const;
+  operator unspecified_bool_type() const
+  { return manager_ ? &InplaceFunction::empty : NULL; }
+
+  void operator()() const
+  {
+    assert(manager_);
+    manager_->invoke(const_cast<Storage*>(&storage_));
+  }
+
+  /// Type of the stored functor, typeid(void) if empty.
+  const std::type_info& target_type() const
+  {
+    return manager_ ? manager_->type() : typeid(void);
+  }
+
+  /// For tests.
+  bool isInline() const { return manager_ != NULL && manager_->isInline; }
+
+ private:
+  union Storage
+  {
+    char bytes[kInlineSize];
+    void* alignPointer;
+    long long alignLongLong;
+    long double alignLongDouble;
+  };
+
+  struct Manager
+  {
+    void (*invoke)(Storage*);
+    void (*clone)(const Storage* from, Storage* to);
+    void (*move)(Storage* from, Storage* to);  //搬到to之后from不再持有函数对象
+    void (*destroy)(Storage*);
+    const std::type_info& (*type)();
+    bool isInline;
+  };
+
+  //放得下的函数对象就地构造在storage_中
+  template<typename F>
+  struct InlineManager
+  {
+    static F* get(Storage* s) { return reinterpret_cast<F*>(s->bytes); }
+    static const F* get(const Storage* s) { return reinterpret_cast<const F*>(s->bytes); }
+    static void invoke(Storage* s) { (*get(s))(); }
+    static void clone(const Storage* from, Storage* to) { new(to->bytes) F(*get(from)); }
+    static void move(Storage* from, Storage* to)
+    {
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+      new(to->bytes) F(std::move(*get(from)));
+#else
+      new(to->bytes) F(*get(from));
+#endif
+      get(from)->~F();
+    }
+    static void destroy(Storage* s) { get(s)->~F(); }
+    static const std::type_info& type() { return typeid(F); }
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+    static void construct(Storage* s, F& f) { new(s->bytes) F(std::move(f)); }
+#else
+    static void construct(Storage* s, F& f) { new(s->bytes) F(f); }
+#endif
+    static const Manager manager;
+  };
+
+  //放不下的在堆上，storage_中只存指针
+  template<typename F>
+  struct HeapManager
+  {
+    static F* get(const Storage* s) { return static_cast<F*>(s->alignPointer); }
+    static void invoke(Storage* s) { (*get(s))(); }
+    static void clone(const Storage* from, Storage* to) { to->alignPointer = new F(*get(from)); }
+    static void move(Storage* from, Storage* to) { to->alignPointer = from->alignPointer; }
+    static void destroy(Storage* s) { delete get(s); }
+    static const std::type_info& type() { return typeid(F); }
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+    static void construct(Storage* s, F& f) { s->alignPointer = new F(std::move(f)); }
+#else
+    static void construct(Storage* s, F& f) { s->alignPointer = new F(f); }
+#endif
+    static const Manager manager;
+  };
+
+  template<typename F, bool Fits>
+  struct ManagerOf
+  {
+    typedef InlineManager<F> type;
+  };
+
+  template<typename F>
+  struct ManagerOf<F, false>
+  {
+    typedef HeapManager<F> type;
+  };
+
+  //空的boost::function和空函数指针转换过来也是空的
+  template<typename F>
+  static bool isEmpty(const F&) { return false; }
+
+  template<typename Signature>
+  static bool isEmpty(const boost::function<Signature>& f) { return f.empty(); }
+
+  template<typename R>
+  static bool isEmpty(R (*f)()) { return f == NULL; }
+
+  void moveFrom(InplaceFunction& rhs)
+  {
+    assert(manager_ == NULL);
+    if (rhs.manager_)
+    {
+      rhs.manager_->move(&rhs.storage_, &storage_);
+      manager_ = rhs.manager_;
+      rhs.manager_ = NULL;
+    }
+  }
+
+  template<typename F>
+  void assign(F& f)
+  {
+    if (isEmpty(f))
+    {
+      return;
+    }
+    typedef typename ManagerOf<F, sizeof(F) <= kInlineSize &&
+        boost::alignment_of<F>::value <= boost::alignment_of<Storage>::value>::type M;
+    M::construct(&storage_, f);
+    manager_ = &M::manager;
+  }
+
+  const Manager* manager_;
+  Storage storage_;
+};
+
+template<typename F>
+const InplaceFunction::Manager InplaceFunction::InlineManager<F>::manager =
+{
+  &InplaceFunction::InlineManager<F>::invoke,
+  &InplaceFunction::InlineManager<F>::clone,
+  &InplaceFunction::InlineManager<F>::move,
+  &InplaceFunction::InlineManager<F>::destroy,
+  &InplaceFunction::InlineManager<F>::type,
+  true
+};
+
+template<typename F>
+const InplaceFunction::Manager InplaceFunction::HeapManager<F>::manager =
+{
+  &InplaceFunction::HeapManager<F>::invoke,
+  &InplaceFunction::HeapManager<F>::clone,
+  &InplaceFunction::HeapManager<F>::move,
+  &InplaceFunction::HeapManager<F>::destroy,
+  &InplaceFunction::HeapManager<F>::type,
+  false
+};
+
+}
+
+#endif  // MUDUO_BASE_INPLACEFUNCTION_H
@@ -13,6 +13,7 @@
 #include <boost/weak_ptr.hpp>
 
 #include <errno.h>
+#include <sched.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <sys/prctl.h>
@@ -75,15 +76,35 @@ struct ThreadData
   ThreadFunc func_;//线程函数
   string name_;//线程名
   boost::weak_ptr<pid_t> wkTid_;//线程tid
+  std::vector<int> cpus_;//要绑定的CPU
 
   ThreadData(const ThreadFunc& func,
              const string& name,
-             const boost::shared_ptr<pid_t>& tid)
+             const boost::shared_ptr<pid_t>& tid,
+             const std::vector<int>& cpus)
     : func_(func),
       name_(name),
-      wkTid_(tid)
+      wkTid_(tid),
+      cpus_(cpus)
   { }
 
+  //在运行线程函数之前绑定CPU，线程函数分配的内存就落在本地NUMA节点上
+  void setAffinity()
+  {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for (size_t i = 0; i < cpus_.size(); ++i)
+    {
+      CPU_SET(cpus_[i], &cpuset);
+    }
+    int ret = ::pthread_setaffinity_np(::pthread_self(), sizeof cpuset, &cpuset);
+    if (ret != 0)
+    {
+      errno = ret;
+      LOG_SYSERR << "Failed in pthread_setaffinity_np, thread " << name_;
+    }
+  }
+
   //ThreadData具体的执行
   void runInThread()
   {
@@ -98,6 +119,10 @@ struct ThreadData
 
     muduo::CurrentThread::t_threadName = name_.empty() ? "muduoThread" : name_.c_str();
     ::prctl(PR_SET_NAME, muduo::CurrentThread::t_threadName);//为线程指定名字
+    if (!cpus_.empty())
+    {
+      setAffinity();
+    }
     try
     {
       func_();//运行线程函数
@@ -220,7 +245,7 @@ void Thread::start()
   assert(!started_);
   started_ = true;
   // FIXME: move(func_)
-  detail::ThreadData* data = new detail::ThreadData(func_, name_, tid_);
+  detail::ThreadData* data = new detail::ThreadData(func_, name_, tid_, cpus_);
   if (pthread_create(&pthreadId_, NULL, &detail::startThread, data)) //创建线程并启动
   {
     started_ = false;
@@ -13,6 +13,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 #include <pthread.h>
+#include <vector>
 
 namespace muduo
 {
@@ -29,6 +30,10 @@ class Thread : boost::noncopyable
 #endif
   ~Thread();
 
+  /// Runs the thread only on these CPUs, see CpuAffinity.
+  /// Must be called before start().
+  void setCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+
   void start();//启动线程
   int join(); // return pthread_join()
 
@@ -48,6 +53,7 @@ class Thread : boost::noncopyable
   boost::shared_ptr<pid_t> tid_;//线程的真实pid，唯一
   ThreadFunc func_; //线程要回调的函数
   string     name_; //线程名称(若不指定，默认为：Thread+序号)
+  std::vector<int> cpus_; //绑定的CPU，空表示不绑定
 
   static AtomicInt32 numCreated_; //原子性的静态成员。已经创建的线程个数,和其他线程个数有关，因此要static
 };
@@ -44,6 +44,7 @@ void ThreadPool::start(int numThreads)
     snprintf(id, sizeof id, "%d", i+1);//线程名
     threads_.push_back(new muduo::Thread(
           boost::bind(&ThreadPool::runInThread, this), name_+id));//创建线程并绑定函数和指定线程名
+    threads_[i].setCpuAffinity(affinity_.cpusOf(i));
     threads_[i].start();//启动线程
   }
   //如果线程池为空，且有回调函数，则调用回调函数。这时相当与只有一个主线程
@@ -7,11 +7,12 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include <muduo/base/Condition.h>
+#include <muduo/base/CpuAffinity.h>
+#include <muduo/base/InplaceFunction.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Types.h>
 
-#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 
@@ -23,7 +24,7 @@ namespace muduo
 class ThreadPool : boost::noncopyable
 {
  public:
-  typedef boost::function<void ()> Task;
+  typedef InplaceFunction Task;
 
   explicit ThreadPool(const string& nameArg = string("ThreadPool"));//构造函数，默认线程池名字ThreadPool
   ~ThreadPool();
@@ -32,6 +33,8 @@ class ThreadPool : boost::noncopyable
   void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
   void setThreadInitCallback(const Task& cb)
   { threadInitCallback_ = cb; }
+  void setCpuAffinity(const CpuAffinity& affinity)
+  { affinity_ = affinity; }
 
   void start(int numThreads);//启动固定的线程数目的线程池
   void stop();//关闭线程池
@@ -58,6 +61,7 @@ class ThreadPool : boost::noncopyable
   Condition notFull_;//未满条件变量
   string name_;//线程池名称
   Task threadInitCallback_;//任务
+  CpuAffinity affinity_;//线程绑定的CPU
   boost::ptr_vector<muduo::Thread> threads_;//线程池中的线程
   std::deque<Task> queue_;//任务队列
   size_t maxQueueSize_;//最大队列大小，若达到最大队列，则需要等待线程（消费者）取出队列
@@ -10,6 +10,7 @@ project "base"
             'AsyncLogging.cc',
             'Condition.cc',
             'CountDownLatch.cc',
+            'CpuAffinity.cc',
             'Date.cc',
             'Exception.cc',
             'FileUtil.cc',
@@ -0,0 +1,66 @@
+#include <muduo/base/CpuAffinity.h>
+#include <muduo/base/Thread.h>
+
+#include <boost/bind.hpp>
+
+#include <assert.h>
+#include <sched.h>
+#include <stdio.h>
+
+using muduo::CpuAffinity;
+
+void testParseCpuList()
+{
+  std::vector<int> cpus = CpuAffinity::parseCpuList("0-3,8,10-11\n");
+  int expected[] = { 0, 1, 2, 3, 8, 10, 11 };
+  assert(cpus == std::vector<int>(expected, expected + sizeof expected / sizeof expected[0]));
+
+  assert(CpuAffinity::parseCpuList("5").size() == 1);
+  assert(CpuAffinity::parseCpuList("").empty());
+  assert(CpuAffinity::parseCpuList("3-1").empty());
+  assert(CpuAffinity::parseCpuList("a").empty());
+}
+
+void testCpusOf()
+{
+  CpuAffinity none;
+  assert(!none.pinned());
+  assert(none.cpusOf(0).empty());
+
+  std::vector<int> list;
+  list.push_back(4);
+  list.push_back(6);
+  CpuAffinity affinity = CpuAffinity::cpuList(list);
+  assert(affinity.cpusOf(0) == std::vector<int>(1, 4));
+  assert(affinity.cpusOf(1) == std::vector<int>(1, 6));
+  assert(affinity.cpusOf(2) == std::vector<int>(1, 4));
+
+  assert(!CpuAffinity::sameNodeAs("no-such-interface").pinned());
+}
+
+void getCpu(int* cpu)
+{
+  *cpu = sched_getcpu();
+}
+
+void testPinnedThread()
+{
+  std::vector<int> allowed = CpuAffinity::allowedCpus();
+  assert(!allowed.empty());
+  int cpu = allowed.back();
+  int actual = -1;
+  muduo::Thread thread(boost::bind(getCpu, &actual));
+  thread.setCpuAffinity(std::vector<int>(1, cpu));
+  thread.start();
+  thread.join();
+  printf("pinned to %d, ran on %d\n", cpu, actual);
+  assert(actual == cpu);
+}
+
+int main()
+{
+  testParseCpuList();
+  testCpusOf();
+  testPinnedThread();
+  printf("All tests passed\n");
+}
@@ -0,0 +1,206 @@
+#include <muduo/base/InplaceFunction.h>
+#include <muduo/base/Types.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <new>
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using muduo::InplaceFunction;
+using muduo::string;
+
+int g_allocations = 0;
+
+// C++11起动态异常说明已经废弃，C++14起还要替换带大小的operator delete
+#if __cplusplus >= 201103L
+#define MUDUO_THROW_BAD_ALLOC
+#define MUDUO_NOTHROW noexcept
+#else
+#define MUDUO_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define MUDUO_NOTHROW throw()
+#endif
+
+void* operator new(size_t size) MUDUO_THROW_BAD_ALLOC
+{
+  ++g_allocations;
+  void* p = malloc(size);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) MUDUO_NOTHROW
+{
+  free(p);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* p, size_t) MUDUO_NOTHROW
+{
+  free(p);
+}
+#endif
+
+struct Foo
+{
+  Foo() : calls(0) { }
+  void bar(const boost::shared_ptr<int>& p, const string& s)
+  {
+    ++calls;
+    assert(*p == 42);
+    assert(s == "hello");
+  }
+  int calls;
+};
+
+struct Large
+{
+  explicit Large(int* calls) : calls_(calls) { }
+  void operator()() { ++*calls_; }
+  int* calls_;
+  char data[200];
+};
+
+int g_plain = 0;
+
+void plain()
+{
+  ++g_plain;
+}
+
+void testInline()
+{
+  Foo foo;
+  boost::shared_ptr<int> p(new int(42));
+  string s("hello");
+  int before = g_allocations;
+  {
+    InplaceFunction f(boost::bind(&Foo::bar, &foo, p, s));
+    assert(f.isInline());
+    InplaceFunction g(f);
+    InplaceFunction h;
+    h = g;
+    f();
+    g();
+    h();
+    assert(foo.calls == 3);
+    assert(p.use_count() == 4);
+  }
+  assert(p.use_count() == 1);
+  // boost::function每次构造和复制都要在堆上分配
+  assert(g_allocations == before);
+}
+
+void testHeap()
+{
+  int calls = 0;
+  InplaceFunction f((Large(&calls)));
+  assert(!f.isInline());
+  InplaceFunction g(f);
+  f();
+  g();
+  assert(calls == 2);
+  f = g;
+  f();
+  assert(calls == 3);
+}
+
+void testEmptyAndSwap()
+{
+  InplaceFunction f;
+  assert(!f);
+  assert(f.empty());
+  assert(f.target_type() == typeid(void));
+
+  InplaceFunction g(plain);
+  assert(g);
+  assert(g.target_type() == typeid(&plain));
+  f.swap(g);
+  assert(f && !g);
+  f();
+  assert(g_plain == 1);
+  f.clear();
+  assert(!f);
+
+  boost::function<void()> none;
+  InplaceFunction h(none);
+  assert(!h);
+  void (*nullFunc)() = NULL;
+  h = nullFunc;
+  assert(!h);
+}
+
+void testSwapWithoutCopy()
+{
+  int calls = 0;
+  InplaceFunction large((Large(&calls)));
+  boost::shared_ptr<int> p(new int(42));
+  Foo foo;
+  InplaceFunction small(boost::bind(&Foo::bar, &foo, p, string("hello")));
+  assert(p.use_count() == 2);
+  int before = g_allocations;
+  large.swap(small);
+  // 堆上的只交换指针
+  assert(g_allocations == before);
+  assert(large.isInline() && !small.isInline());
+  assert(p.use_count() == 2);
+  large();
+  small();
+  assert(foo.calls == 1 && calls == 1);
+}
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+void testMove()
+{
+  int calls = 0;
+  InplaceFunction f((Large(&calls)));
+  int before = g_allocations;
+  InplaceFunction g(std::move(f));
+  assert(!f && g);
+  f = std::move(g);
+  assert(f && !g);
+  assert(g_allocations == before);
+  f();
+  assert(calls == 1);
+}
+
+//参数本身已经是副本，存进去只应搬移，不再复制绑定的string
+template<typename F>
+int allocationsToStore(F f)
+{
+  int before = g_allocations;
+  InplaceFunction g(std::move(f));
+  assert(g.isInline());
+  return g_allocations - before;
+}
+
+void testStoreWithoutCopy()
+{
+  Foo foo;
+  boost::shared_ptr<int> p(new int(42));
+  string s("hello, a string too long for short string optimization");
+  assert(s.size() > 15);
+  assert(allocationsToStore(boost::bind(&Foo::bar, &foo, p, s)) == 0);
+  assert(p.use_count() == 1);
+}
+#endif
+
+int main()
+{
+  testInline();
+  testHeap();
+  testEmptyAndSwap();
+  testSwapWithoutCopy();
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+  testMove();
+  testStoreWithoutCopy();
+#endif
+  printf("All tests passed\n");
+}
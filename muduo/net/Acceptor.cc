@@ -23,12 +23,34 @@
 using namespace muduo;
 using namespace muduo::net;
 
+AtomicInt64 Acceptor::s_numAccepted_;
+AtomicInt64 Acceptor::s_numShed_;
+AtomicInt64 Acceptor::s_numWakeups_;
+AtomicInt64 Acceptor::s_batchSizes_[Acceptor::kNumBatchBuckets];
+
+namespace
+{
+
+int batchBucket(int n)
+{
+  int bucket = 0;
+  while (n > 0 && bucket < Acceptor::kNumBatchBuckets - 1)
+  {
+    n >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+}
+
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport)
   : loop_(loop),
     acceptSocket_(sockets::createNonblockingOrDie(listenAddr.family())),  //初始化创建sockt fd
     acceptChannel_(loop, acceptSocket_.fd()),  //初始化channel与sockfd绑定
     listenning_(false), //初始化未监听
-    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))  //打开一个空洞文件(/dev/null)后返回一空闲的文件描述符！
+    idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC)),  //打开一个空洞文件(/dev/null)后返回一空闲的文件描述符！
+    acceptBudget_(kDefaultAcceptBudget)
 {
   assert(idleFd_ >= 0);
   acceptSocket_.setReuseAddr(true); //不用等待Time_Wait状态结束
@@ -53,41 +75,81 @@ void Acceptor::listen()
   acceptChannel_.enableReading(); //listen完毕才使能读事件
 }
 
-//sockfd可读,接收连接,执行TcpServer::newConnection
+void Acceptor::setAcceptBudget(int n)
+{
+  assert(n > 0);
+  acceptBudget_ = n;
+}
+
+//sockfd可读,循环接收连接,执行TcpServer::newConnection
 void Acceptor::handleRead()
 {
   loop_->assertInLoopThread();
-  InetAddress peerAddr;
-  //FIXME loop until no more
-  int connfd = acceptSocket_.accept(&peerAddr); //这里是真正接收连接
-  if (connfd >= 0)  //接受连接成功，则执行连接回调
+  int accepted = 0;
+  int shed = 0;
+  for (int i = 0; i < acceptBudget_; ++i)
   {
-    // string hostport = peerAddr.toIpPort();
-    // LOG_TRACE << "Accepts of " << hostport;
-   //回调函数在TcpServer构造函数中设置
-    if (newConnectionCallback_)
+    InetAddress peerAddr;
+    int connfd = acceptSocket_.accept(&peerAddr); //这里是真正接收连接
+    if (connfd >= 0)  //接受连接成功，则执行连接回调
     {
-      newConnectionCallback_(connfd, peerAddr); //TcpServer::newConnection
+      ++accepted;
+      // string hostport = peerAddr.toIpPort();
+      // LOG_TRACE << "Accepts of " << hostport;
+      //回调函数在TcpServer构造函数中设置
+      if (newConnectionCallback_)
+      {
+        newConnectionCallback_(connfd, peerAddr); //TcpServer::newConnection
+      }
+      else  //没有回调函数则关闭client对应的fd
+      {
+        sockets::close(connfd);
+      }
     }
-    else  //没有回调函数则关闭client对应的fd
+    else if (errno == EAGAIN || errno == EWOULDBLOCK)  //积压的连接已经取完
     {
-      sockets::close(connfd);
+      break;
     }
-  }
-  else  //接收套接字失败
-  {
-    LOG_SYSERR << "in Acceptor::handleRead";
-    // Read the section named "The special problem of
-    // accept()ing when you can't" in libev's doc.
-    // By Marc Lehmann, author of libev.
-    if (errno == EMFILE)  //返回的错误码为EMFILE(超过最大连接数)
+    else  //接收套接字失败
     {
-      ::close(idleFd_); //把提前拥有的idleFd_关掉，这样就腾出来文件描述符来接受新连接了
-      idleFd_ = ::accept(acceptSocket_.fd(), NULL, NULL);
-      ::close(idleFd_); //接受到新连接之后将其关闭，然后我们就再次获得一个空洞文件描述符保存到idleFd_中
-      idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+      LOG_SYSERR << "in Acceptor::handleRead";
+      // Read the section named "The special problem of
+      // accept()ing when you can't" in libev's doc.
+      // By Marc Lehmann, author of libev.
+      if (errno == EMFILE)  //返回的错误码为EMFILE(超过最大连接数)
+      {
+        if (!shedOne())  //EMFILE不说明还有积压的连接，取不到就停下
+        {
+          break;
+        }
+        ++shed;
+      }
+      // ECONNABORTED等：这个连接没了，继续取下一个
     }
   }
+
+  s_numWakeups_.increment();
+  s_batchSizes_[batchBucket(accepted)].increment();
+  if (accepted > 0)
+  {
+    s_numAccepted_.add(accepted);
+  }
+  if (shed > 0)
+  {
+    s_numShed_.add(shed);
+  }
+}
+
+bool Acceptor::shedOne()
+{
+  ::close(idleFd_); //把提前拥有的idleFd_关掉，这样就腾出来文件描述符来接受新连接了
+  int fd = ::accept(acceptSocket_.fd(), NULL, NULL);
+  if (fd >= 0)
+  {
+    ::close(fd); //接受到新连接之后将其关闭
+  }
+  idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);  //然后我们就再次获得一个空洞文件描述符保存到idleFd_中
+  return fd >= 0;
 }
 
 /*
@@ -14,6 +14,7 @@
 #include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 
+#include <muduo/base/Atomic.h>
 #include <muduo/net/Channel.h>
 #include <muduo/net/Socket.h>
 
@@ -46,8 +47,24 @@ class Acceptor : boost::noncopyable
   bool listenning() const { return listenning_; } 
   void listen();  //该接口用来启动监听套接字
 
+  /// Accepts at most n connections per wakeup, default kDefaultAcceptBudget.
+  /// 每次可读时循环accept，直到EAGAIN或者达到budget，避免积压的连接每个都要一次epoll_wait
+  void setAcceptBudget(int n);
+  int acceptBudget() const { return acceptBudget_; }
+
+  static const int kDefaultAcceptBudget = 64;
+  /// 每次wakeup接受连接数的直方图，第0个桶是0个，第i个桶是[2^(i-1), 2^i)，最后一个桶不封顶
+  static const int kNumBatchBuckets = 9;
+
+  // 整个进程所有Acceptor的计数，见NetInspector
+  static int64_t numAccepted() { return s_numAccepted_.get(); }
+  static int64_t numShed() { return s_numShed_.get(); }  //EMFILE时借idleFd_接受后立即关闭的连接数
+  static int64_t numWakeups() { return s_numWakeups_.get(); }
+  static int64_t numBatches(int bucket) { return s_batchSizes_[bucket].get(); }
+
  private:
   void handleRead();  //处理新连接到来的私有函数
+  bool shedOne();  //文件描述符用完了，接受一个连接并立即关闭，没有连接可取时返回false
 
   EventLoop* loop_; //监听事件放在该loop循环中
   Socket acceptSocket_; //对监听套接字的封装
@@ -55,6 +72,12 @@ class Acceptor : boost::noncopyable
   NewConnectionCallback newConnectionCallback_;//用户定义的连接回调函数
   bool listenning_; //是否正在监听状态
   int idleFd_;  //解决了服务器中文件描述符达到上限后如何处理的大问题!
+  int acceptBudget_;
+
+  static AtomicInt64 s_numAccepted_;
+  static AtomicInt64 s_numShed_;
+  static AtomicInt64 s_numWakeups_;
+  static AtomicInt64 s_batchSizes_[kNumBatchBuckets];
 };
 
 }
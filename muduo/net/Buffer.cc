@@ -9,9 +9,15 @@
 
 #include <muduo/net/Buffer.h>
 
+#include <muduo/net/BufferPool.h>
+#include <muduo/net/DelimiterSearch.h>
 #include <muduo/net/SocketsOps.h>
 
+#include <algorithm>
+#include <limits>
+
 #include <errno.h>
+#include <stdlib.h>
 #include <sys/uio.h>
 
 using namespace muduo;
@@ -22,20 +28,166 @@ const char Buffer::kCRLF[] = "\r\n";
 const size_t Buffer::kCheapPrepend;
 const size_t Buffer::kInitialSize;
 
+Buffer::Buffer(BufferPool* pool, size_t initialSize)
+  : data_(NULL),
+    size_(0),
+    capacity_(0),
+    pool_(pool),
+    readerIndex_(0),
+    writerIndex_(0)
+{
+  if (initialSize > 0)
+  {
+    reallocate(kCheapPrepend + initialSize);
+    size_ = kCheapPrepend + initialSize;
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = kCheapPrepend;
+  }
+}
+
+Buffer::Buffer(const Buffer& rhs)
+  : data_(NULL),
+    size_(rhs.size_),
+    capacity_(rhs.size_),
+    pool_(NULL),
+    readerIndex_(rhs.readerIndex_),
+    writerIndex_(rhs.writerIndex_)
+{
+  if (capacity_ > 0)
+  {
+    data_ = allocate(NULL, &capacity_);
+    ::memcpy(data_ + readerIndex_, rhs.peek(), readableBytes());
+  }
+}
+
+void Buffer::setPool(BufferPool* pool)
+{
+  if (pool == pool_)
+  {
+    return;
+  }
+  if (readableBytes() == 0)
+  {
+    shrink(0);
+    pool_ = pool;
+    return;
+  }
+  size_t capacity = size_;
+  char* data = allocate(pool, &capacity);
+  ::memcpy(data + readerIndex_, peek(), readableBytes());
+  deallocate(pool_, data_, capacity_);
+  data_ = data;
+  capacity_ = capacity;
+  pool_ = pool;
+}
+
+//交换内存之后再各自搬回原来的pool，池中的内存只在所属loop线程中归还
+void Buffer::swapAcrossPools(Buffer& rhs)
+{
+  BufferPool* pool = pool_;
+  BufferPool* rhsPool = rhs.pool_;
+  std::swap(data_, rhs.data_);
+  std::swap(size_, rhs.size_);
+  std::swap(capacity_, rhs.capacity_);
+  std::swap(pool_, rhs.pool_);
+  std::swap(readerIndex_, rhs.readerIndex_);
+  std::swap(writerIndex_, rhs.writerIndex_);
+  setPool(pool);
+  rhs.setPool(rhsPool);
+}
+
+void Buffer::reallocate(size_t capacity)
+{
+  char* data = allocate(pool_, &capacity);
+  if (data_)
+  {
+    ::memcpy(data + readerIndex_, peek(), readableBytes());
+    deallocate(pool_, data_, capacity_);
+  }
+  data_ = data;
+  capacity_ = capacity;
+}
+
+char* Buffer::allocate(BufferPool* pool, size_t* capacity)
+{
+  if (pool)
+  {
+    return pool->allocate(capacity);
+  }
+  char* data = static_cast<char*>(::malloc(*capacity));
+  if (data == NULL)
+  {
+    abort();
+  }
+  return data;
+}
+
+void Buffer::deallocate(BufferPool* pool, char* data, size_t capacity)
+{
+  if (pool)
+  {
+    pool->deallocate(data, capacity);
+  }
+  else
+  {
+    ::free(data);
+  }
+}
+
+const char* Buffer::findCRLF(const char* start) const
+{
+  assert(peek() <= start);
+  assert(start <= beginWrite());
+  return detail::findDelimiter(start, beginWrite(), kCRLF, 2);
+}
+
+const char* Buffer::findCRLF(size_t* scanned) const
+{
+  return findDelimiter(StringPiece(kCRLF, 2), scanned);
+}
+
+const char* Buffer::findDelimiter(const StringPiece& delimiter, size_t* scanned) const
+{
+  const size_t readable = readableBytes();
+  const size_t len = delimiter.size();
+  const size_t from = std::min(*scanned, readable);
+  const char* found = detail::findDelimiter(peek() + from, beginWrite(), delimiter.data(), len);
+  if (found)
+  {
+    *scanned = found - peek();
+  }
+  else if (len > 0 && readable >= len)
+  {
+    //末尾不足len个字节的可能是分隔符的前一部分，下次从那里开始
+    *scanned = std::max(from, readable - len + 1);
+  }
+  else
+  {
+    *scanned = from;
+  }
+  return found;
+}
+
 //读取sockfd的数据到Buffer,可参见TcpConnection类
 ssize_t Buffer::readFd(int fd, int* savedErrno)
+{
+  return readFd(fd, savedErrno, std::numeric_limits<size_t>::max());
+}
+
+ssize_t Buffer::readFd(int fd, int* savedErrno, size_t maxBytes)
 {
   // saved an ioctl()/FIONREAD call to tell how much to read
   char extrabuf[65536]; //从fd读数据到Buffer中时，因为不知道一次性可以读多少，因此在栈上开辟了65536字节的空间extrabuf，使用readv读取
   struct iovec vec[2];    
-  const size_t writable = writableBytes();  //Buffer中wriable足够存放从fd读到的数据，则读取完毕；否则剩余数据读到extrabuf中，再将其添加到Buffer中。
+  //Buffer中wriable足够存放从fd读到的数据，则读取完毕；否则剩余数据读到extrabuf中，再将其添加到Buffer中。
+  const size_t writable = std::min(writableBytes(), maxBytes);
   vec[0].iov_base = begin()+writerIndex_; //内存1起始地址
   vec[0].iov_len = writable;  //这块内存1长度
   vec[1].iov_base = extrabuf; //内存2起始地址
-  vec[1].iov_len = sizeof extrabuf; //这块内存2长度
+  vec[1].iov_len = std::min(sizeof extrabuf, maxBytes - writable); //这块内存2长度
   // when there is enough space in this buffer, don't read into extrabuf. 
   // when extrabuf is used, we read 128k-1 bytes at most.   
-  const int iovcnt = (writable < sizeof extrabuf) ? 2 : 1;//决定要使用几个内存块
+  const int iovcnt = (writable < sizeof extrabuf && vec[1].iov_len > 0) ? 2 : 1;//决定要使用几个内存块
   const ssize_t n = sockets::readv(fd, vec, iovcnt);  //从fd中读取内容到vec内存块
   if (n < 0)
   {
@@ -47,7 +199,7 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
   }
   else  //读的数据太多，部分先存储到栈extrabuf,再添加到Buffer中
   {
-    writerIndex_ = buffer_.size();
+    writerIndex_ += writable;
     append(extrabuf, n - writable); //把extrabuf中的数据追加到Buffer中
   }
   // if (n == writable + sizeof extrabuf)
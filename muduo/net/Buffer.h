@@ -18,7 +18,6 @@
 #include <muduo/net/Endian.h>
 
 #include <algorithm>
-#include <vector>
 
 #include <assert.h>
 #include <string.h>
@@ -29,6 +28,8 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
+
 /// A buffer class modeled after org.jboss.netty.buffer.ChannelBuffer
 ///
 /// @code
@@ -39,6 +40,9 @@ namespace net
 /// |                   |                  |                  |
 /// 0      <=      readerIndex   <=   writerIndex    <=     size
 /// @endcode
+///
+/// Storage is allocated by malloc(3), or by the BufferPool of an EventLoop,
+/// and is not zeroed.
 class Buffer : public muduo::copyable
 {
  public:
@@ -46,30 +50,87 @@ class Buffer : public muduo::copyable
   static const size_t kInitialSize = 1024;  //初始化存储数据空间
 
   explicit Buffer(size_t initialSize = kInitialSize)  //初始化Buffer总大小
-    : buffer_(kCheapPrepend + initialSize),
+    : data_(NULL),
+      size_(0),
+      capacity_(0),
+      pool_(NULL),
       readerIndex_(kCheapPrepend),
       writerIndex_(kCheapPrepend)
   {
+    reallocate(kCheapPrepend + initialSize);
+    size_ = kCheapPrepend + initialSize;
     assert(readableBytes() == 0);
     assert(writableBytes() == initialSize);
     assert(prependableBytes() == kCheapPrepend);
   }
 
-  // implicit copy-ctor, move-ctor, dtor and assignment are fine
-  // NOTE: implicit move-ctor is added in g++ 4.6
+  /// Storage comes from @c pool, the buffer must only be used
+  /// in the loop thread of @c pool until setPool(NULL).
+  /// Pooled storage never moves to another Buffer, see swap().
+  /// Allocates @c initialSize bytes, or nothing if it is 0,
+  /// so it can be constructed in other threads.
+  Buffer(BufferPool* pool, size_t initialSize);
+
+  /// Copies use malloc(3), never a pool.
+  Buffer(const Buffer& rhs);
 
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+  /// Takes the storage of @c rhs, or copies it if it comes from a pool.
+  Buffer(Buffer&& rhs)
+    : data_(NULL),
+      size_(0),
+      capacity_(0),
+      pool_(NULL),
+      readerIndex_(0),
+      writerIndex_(0)
+  {
+    swap(rhs);
+  }
+#endif
+
+  ~Buffer()
+  {
+    if (data_)
+    {
+      deallocate(pool_, data_, capacity_);
+    }
+  }
+
+  Buffer& operator=(const Buffer& rhs)
+  {
+    Buffer copy(rhs);
+    swap(copy);
+    return *this;
+  }
+
+  /// Exchanges contents, each buffer keeps its pool.  Storage is
+  /// exchanged only when both use the same pool, otherwise it is copied,
+  /// so that pooled memory never ends up in a buffer freed in another thread.
   void swap(Buffer& rhs)
   {
-    buffer_.swap(rhs.buffer_);
+    if (pool_ != rhs.pool_)
+    {
+      swapAcrossPools(rhs);
+      return;
+    }
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    std::swap(capacity_, rhs.capacity_);
     std::swap(readerIndex_, rhs.readerIndex_);
     std::swap(writerIndex_, rhs.writerIndex_);
   }
 
+  /// Moves storage to @c pool, or to malloc(3) if NULL.
+  /// An empty buffer frees its storage, allocated again on the next write.
+  /// Must be called in the loop thread of both pools.
+  void setPool(BufferPool* pool);
+  BufferPool* pool() const { return pool_; }
+
   size_t readableBytes() const  //可读空间有多大（即存储多少内容）
   { return writerIndex_ - readerIndex_; }
 
   size_t writableBytes() const  //可写入空间有多大
-  { return buffer_.size() - writerIndex_; }
+  { return size_ - writerIndex_; }
 
   size_t prependableBytes() const //可前置的字节
   { return readerIndex_; }
@@ -79,20 +140,28 @@ class Buffer : public muduo::copyable
 
   const char* findCRLF() const  //在[peek(), beginWrite())中找\r\n
   {
-    // FIXME: replace with memmem()?
-    const char* crlf = std::search(peek(), beginWrite(), kCRLF, kCRLF+2); //返回指针
-    return crlf == beginWrite() ? NULL : crlf;
+    return findCRLF(peek());
   }
 
-  const char* findCRLF(const char* start) const //从位置start开始查找\r\n
+  const char* findCRLF(const char* start) const; //从位置start开始查找\r\n
+
+  /// Resumes from @c *scanned bytes after peek(), where the last call
+  /// gave up, so a line arriving in pieces is not scanned again and again.
+  /// Sets @c *scanned to the offset of \r\n if found, otherwise to
+  /// where to resume.  Reset it to 0 after retrieving.
+  const char* findCRLF(size_t* scanned) const;
+
+  /// Finds @c delimiter in the readable bytes, NULL if not found.
+  /// Fastest for 1 to 4 bytes, e.g. "\r\n\r\n".
+  const char* findDelimiter(const StringPiece& delimiter) const
   {
-    assert(peek() <= start);
-    assert(start <= beginWrite());
-    // FIXME: replace with memmem()?
-    const char* crlf = std::search(start, beginWrite(), kCRLF, kCRLF+2);
-    return crlf == beginWrite() ? NULL : crlf;
+    size_t scanned = 0;
+    return findDelimiter(delimiter, &scanned);
   }
 
+  /// Resumable like findCRLF(size_t*).
+  const char* findDelimiter(const StringPiece& delimiter, size_t* scanned) const;
+
   const char* findEOL() const //查找'\n'的位置
   {
     const void* eol = memchr(peek(), '\n', readableBytes());
@@ -152,8 +221,8 @@ class Buffer : public muduo::copyable
 
   void retrieveAll()  //全部取走
   {
-    readerIndex_ = kCheapPrepend;
-    writerIndex_ = kCheapPrepend;
+    readerIndex_ = size_ == 0 ? 0 : kCheapPrepend;  //shrink(0)释放了内存时没有预留空间
+    writerIndex_ = readerIndex_;
   }
 
   string retrieveAllAsString()  //Buffer中所有数据以字符串形式取走
@@ -359,10 +428,24 @@ class Buffer : public muduo::copyable
     std::copy(d, d+len, begin()+readerIndex_);
   }
 
+  /// shrink(0) of an empty buffer frees all its memory,
+  /// which is allocated again on the next write.
   void shrink(size_t reserve) //更改Buffer的大小，使其可写入空间为reserve大小
   {
-    // FIXME: use vector::shrink_to_fit() in C++ 11 if possible.
-    Buffer other;
+    if (reserve == 0 && readableBytes() == 0)
+    {
+      if (data_)
+      {
+        deallocate(pool_, data_, capacity_);
+      }
+      data_ = NULL;
+      size_ = 0;
+      capacity_ = 0;
+      readerIndex_ = 0;
+      writerIndex_ = 0;
+      return;
+    }
+    Buffer other(pool_, kInitialSize);  //从同一个pool分配
     other.ensureWritableBytes(readableBytes()+reserve);
     other.append(toStringPiece());
     swap(other);
@@ -370,7 +453,7 @@ class Buffer : public muduo::copyable
 
   size_t internalCapacity() const
   {
-    return buffer_.capacity();
+    return capacity_;
   }
 
   /// Read data directly into buffer.
@@ -378,21 +461,29 @@ class Buffer : public muduo::copyable
   /// It may implement with readv(2)
   /// @return result of read(2), @c errno is saved
   ssize_t readFd(int fd, int* savedErrno);//读取sockfd的数据到Buffer,可参见TcpConnection类
+  /// Reads at most @c maxBytes.
+  ssize_t readFd(int fd, int* savedErrno, size_t maxBytes);
 
  private:
 
   char* begin() //返回Buffer的起始地址
-  { return &*buffer_.begin(); }
+  { return data_; }
 
   const char* begin() const
-  { return &*buffer_.begin(); }
+  { return data_; }
 
   void makeSpace(size_t len)  //resize或移动数据，使Buffer能容下len大数据
   {
-    if (writableBytes() + prependableBytes() < len + kCheapPrepend) //Buffer总的空间不够大
+    if (size_ == 0)  //shrink(0)释放过内存
+    {
+      resize(kCheapPrepend + len);
+      readerIndex_ = kCheapPrepend;
+      writerIndex_ = kCheapPrepend;
+    }
+    else if (writableBytes() + prependableBytes() < len + kCheapPrepend) //Buffer总的空间不够大
     {
       // FIXME: move readable data
-      buffer_.resize(writerIndex_+len);
+      resize(writerIndex_+len);
     }
     else  //通过数据前移可以腾出足够大空间
     {
@@ -408,8 +499,26 @@ class Buffer : public muduo::copyable
     }
   }
 
+  //跟vector::resize()一样，容量不够时至少翻倍，但新增的部分不清零
+  void resize(size_t size)
+  {
+    if (size > capacity_)
+    {
+      reallocate(std::max(size, 2*capacity_));
+    }
+    size_ = size;
+  }
+
+  void reallocate(size_t capacity);  //只保留可读的数据，位置不变
+  void swapAcrossPools(Buffer& rhs);
+  static char* allocate(BufferPool* pool, size_t* capacity);
+  static void deallocate(BufferPool* pool, char* data, size_t capacity);
+
  private:
-  std::vector<char> buffer_;  //连续内存
+  char* data_;  //连续内存
+  size_t size_;  //即图中的size
+  size_t capacity_;  //分配了多少，pool会向上取整
+  BufferPool* pool_;  //NULL表示用malloc
   size_t readerIndex_;  //可读起始位置
   size_t writerIndex_;  //可写入起始位置
 
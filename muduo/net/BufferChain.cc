@@ -0,0 +1,299 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include <muduo/net/BufferChain.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/base/ThreadLocalSingleton.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>  // IOV_MAX
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const size_t BufferChain::kBlockSize;
+const size_t BufferChain::kMaxFreeBlocks;
+
+struct BufferChain::Block
+{
+  char data[kBlockSize];
+};
+
+//每个线程一个空闲块链表，BufferChain只在所属IO线程中使用，所以不用加锁
+//块在哪个线程释放就归还到哪个线程的链表中
+class BufferChain::BlockPool : boost::noncopyable
+{
+ public:
+  ~BlockPool()
+  {
+    for (size_t i = 0; i < free_.size(); ++i)
+    {
+      delete free_[i];
+    }
+  }
+
+  Block* get()
+  {
+    Block* block = NULL;
+    if (free_.empty())
+    {
+      block = new Block;
+    }
+    else
+    {
+      block = free_.back();
+      free_.pop_back();
+    }
+    return block;
+  }
+
+  void put(Block* block)
+  {
+    if (free_.size() < kMaxFreeBlocks)
+    {
+      free_.push_back(block);
+    }
+    else
+    {
+      delete block;
+    }
+  }
+
+ private:
+  std::vector<Block*> free_;
+};
+
+BufferChain::Block* BufferChain::newBlock()
+{
+  return ThreadLocalSingleton<BlockPool>::instance().get();
+}
+
+void BufferChain::freeBlock(Block* block)
+{
+  ThreadLocalSingleton<BlockPool>::instance().put(block);
+}
+
+const char* BufferChain::Segment::peek() const
+{
+  assert(fd < 0);
+  const char* base = block ? block->data : message->data();
+  return base + readerIndex;
+}
+
+BufferChain::BufferChain()
+  : readableBytes_(0)
+{
+}
+
+BufferChain::~BufferChain()
+{
+  retrieveAll();
+}
+
+void BufferChain::append(const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    if (blocks_.empty()
+        || blocks_.back().block == NULL
+        || blocks_.back().writerIndex == kBlockSize)
+    {
+      Segment seg;  //最后一块已满或是共享的message，挂一块新的到链尾
+      seg.block = newBlock();
+      seg.fd = -1;
+      seg.fileOffset = 0;
+      seg.readerIndex = 0;
+      seg.writerIndex = 0;
+      blocks_.push_back(seg);
+    }
+    Segment& seg = blocks_.back();
+    size_t n = std::min(len, kBlockSize - seg.writerIndex);
+    ::memcpy(seg.block->data + seg.writerIndex, data, n);
+    seg.writerIndex += n;
+    readableBytes_ += n;
+    data += n;
+    len -= n;
+  }
+}
+
+void BufferChain::append(const SharedStringPtr& message, size_t offset)
+{
+  assert(offset <= message->size());
+  if (offset < message->size())
+  {
+    Segment seg;
+    seg.block = NULL;
+    seg.message = message;  //只增加引用计数，不拷贝数据
+    seg.fd = -1;
+    seg.fileOffset = 0;
+    seg.readerIndex = offset;
+    seg.writerIndex = message->size();
+    blocks_.push_back(seg);
+    readableBytes_ += seg.readableBytes();
+  }
+}
+
+void BufferChain::appendFile(int fd, off_t offset, size_t length)
+{
+  assert(fd >= 0);
+  if (length > 0)
+  {
+    Segment seg;
+    seg.block = NULL;
+    seg.fd = fd;
+    seg.fileOffset = offset;
+    seg.readerIndex = 0;
+    seg.writerIndex = length;
+    blocks_.push_back(seg);
+    readableBytes_ += length;
+  }
+  else
+  {
+    ::close(fd);
+  }
+}
+
+void BufferChain::popFront()
+{
+  assert(!blocks_.empty());
+  const Segment& seg = blocks_.front();
+  if (seg.block)
+  {
+    freeBlock(seg.block);
+  }
+  else if (seg.fd >= 0)
+  {
+    ::close(seg.fd);  //文件段发送完毕或被丢弃，关闭fd
+  }
+  blocks_.pop_front();  //共享的message在这里释放引用
+}
+
+void BufferChain::retrieve(size_t len)
+{
+  assert(len <= readableBytes_);
+  readableBytes_ -= len;
+  while (len > 0)
+  {
+    assert(!blocks_.empty());
+    Segment& seg = blocks_.front();
+    size_t n = std::min(len, seg.readableBytes());
+    seg.readerIndex += n;
+    len -= n;
+    if (seg.readableBytes() == 0)
+    {
+      popFront();
+    }
+  }
+}
+
+void BufferChain::retrieveAll()
+{
+  while (!blocks_.empty())
+  {
+    popFront();
+  }
+  readableBytes_ = 0;
+}
+
+string BufferChain::retrieveAllAsString()
+{
+  string result;
+  result.reserve(readableBytes_);
+  for (std::deque<Segment>::const_iterator it = blocks_.begin();
+       it != blocks_.end(); ++it)
+  {
+    if (it->fd < 0)
+    {
+      result.append(it->peek(), it->readableBytes());
+    }
+    else
+    {
+      //文件段只能读出来了
+      char buf[64*1024];
+      size_t nread = 0;
+      while (nread < it->readableBytes())
+      {
+        size_t n = std::min(sizeof buf, it->readableBytes() - nread);
+        ssize_t nr = ::pread(it->fd, buf, n, it->fileOffset + static_cast<off_t>(it->readerIndex + nread));
+        if (nr <= 0)
+        {
+          LOG_SYSERR << "BufferChain::retrieveAllAsString pread fd = " << it->fd;
+          break;
+        }
+        result.append(buf, nr);
+        nread += nr;
+      }
+    }
+  }
+  retrieveAll();
+  return result;
+}
+
+//一次writev(2)最多发送IOV_MAX块，省去Buffer::makeSpace()的拷贝
+ssize_t BufferChain::writeFd(int fd, int* savedErrno)
+{
+  if (!blocks_.empty() && blocks_.front().fd >= 0)
+  {
+    return sendFile(fd, savedErrno);
+  }
+
+  struct iovec vec[IOV_MAX];
+  int iovcnt = 0;
+  for (std::deque<Segment>::const_iterator it = blocks_.begin();
+       it != blocks_.end() && it->fd < 0 && iovcnt < IOV_MAX; ++it)  //遇到文件段就停下，下次再sendfile
+  {
+    vec[iovcnt].iov_base = const_cast<char*>(it->peek());
+    vec[iovcnt].iov_len = it->readableBytes();
+    ++iovcnt;
+  }
+  const ssize_t n = sockets::writev(fd, vec, iovcnt);
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else
+  {
+    retrieve(n);
+  }
+  return n;
+}
+
+//文件数据由内核直接从page cache发往socket
+ssize_t BufferChain::sendFile(int fd, int* savedErrno)
+{
+  const Segment& seg = blocks_.front();
+  off_t offset = seg.fileOffset + static_cast<off_t>(seg.readerIndex);
+  const ssize_t n = sockets::sendfile(fd, seg.fd, &offset, seg.readableBytes());
+  if (n < 0)
+  {
+    *savedErrno = errno;
+  }
+  else if (n == 0)
+  {
+    //文件比appendFile()时说的短(比如被截断了)，丢弃剩下的部分，否则会busy loop
+    LOG_ERROR << "BufferChain::sendFile fd = " << seg.fd << " reaches EOF, "
+              << seg.readableBytes() << " bytes dropped";
+    readableBytes_ -= seg.readableBytes();
+    popFront();
+  }
+  else
+  {
+    retrieve(n);
+  }
+  return n;
+}
@@ -0,0 +1,119 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_BUFFERCHAIN_H
+#define MUDUO_NET_BUFFERCHAIN_H
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+#include <muduo/net/Callbacks.h>
+
+#include <deque>
+#include <boost/noncopyable.hpp>
+
+#include <sys/types.h>  // off_t
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Output queue made of fixed-size blocks, flushed with writev(2).
+///
+/// @code
+/// +--------------+    +--------------+    +--------------+
+/// | ... |CONTENT | -> |   CONTENT    | -> | CONTENT| ... |
+/// +--------------+    +--------------+    +--------------+
+///       ^readerIndex                               ^writerIndex
+/// @endcode
+///
+/// 与Buffer不同，append()从不移动已缓存的数据，也不会realloc：
+/// 最后一块写满后，从本线程的空闲块链表中再取一块挂到链尾。
+/// append(SharedStringPtr)只挂一个引用，不拷贝数据，发送完毕后释放引用。
+/// appendFile()挂一段文件，轮到它时用sendfile(2)发送，数据不经过用户态。
+/// 用作TcpConnection的输出缓冲，见TcpConnection::setOutputChain()
+class BufferChain : boost::noncopyable
+{
+ public:
+  static const size_t kBlockSize = 16*1024;  //每块的大小
+  static const size_t kMaxFreeBlocks = 256;  //每个线程最多缓存的空闲块数
+
+  BufferChain();
+  ~BufferChain();
+
+  size_t readableBytes() const  //所有块中待发送数据的总字节数
+  { return readableBytes_; }
+
+  size_t numBlocks() const
+  { return blocks_.size(); }
+
+  void append(const StringPiece& str)
+  {
+    append(str.data(), str.size());
+  }
+
+  void append(const void* /*restrict*/ data, size_t len)
+  {
+    append(static_cast<const char*>(data), len);
+  }
+
+  void append(const char* /*restrict*/ data, size_t len);  //追加到链尾，不够时新增块
+
+  /// Queue a reference of message, starting from offset, no copy.
+  void append(const SharedStringPtr& message, size_t offset = 0);
+
+  /// Queue [offset, offset+length) of file fd, takes ownership of fd,
+  /// it is closed after sent or discarded.
+  void appendFile(int fd, off_t offset, size_t length);
+
+  void retrieve(size_t len);  //取走len字节，读完的块归还空闲链表
+  void retrieveAll();
+  string retrieveAllAsString();
+
+  /// Write data directly from blocks.
+  ///
+  /// At most IOV_MAX blocks per writev(2), written bytes are retrieved.
+  /// A file segment at front is written by sendfile(2) instead,
+  /// if the file ends early, the rest of the segment is dropped and 0 is returned.
+  /// @return result of writev(2) or sendfile(2), @c errno is saved
+  ssize_t writeFd(int fd, int* savedErrno);
+
+ private:
+  struct Block;
+  class BlockPool;
+
+  //链表中的一段，数据在池化的block中，或在共享的message中，或在文件fd中
+  struct Segment
+  {
+    Block* block;
+    SharedStringPtr message;
+    int fd;             //文件段的fd，其他段为-1
+    off_t fileOffset;   //文件段在文件中的起始位置
+    size_t readerIndex;
+    size_t writerIndex;
+
+    const char* peek() const;
+    size_t readableBytes() const { return writerIndex - readerIndex; }
+  };
+
+  static Block* newBlock();
+  static void freeBlock(Block* block);
+  void popFront();
+  ssize_t sendFile(int fd, int* savedErrno);
+
+  std::deque<Segment> blocks_;  //块链表，front()是最早写入的数据
+  size_t readableBytes_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_BUFFERCHAIN_H
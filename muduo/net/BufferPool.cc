@@ -0,0 +1,193 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/BufferPool.h>
+
+#include <muduo/base/CurrentThread.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int BufferPool::kMinShift;
+const int BufferPool::kMaxShift;
+const int BufferPool::kNumClasses;
+const int BufferPool::kLargeClass;
+const size_t BufferPool::kMaxCachedBytesPerClass;
+const int BufferPool::kMinCachedBlocks;
+
+BufferPool::BufferPool()
+  : threadId_(CurrentThread::tid()),
+    orphaned_(false),
+    blocks_(0)
+{
+  std::fill(freeLists_, freeLists_ + kNumClasses, static_cast<FreeBlock*>(NULL));
+}
+
+BufferPool::~BufferPool()
+{
+  freeCached();
+}
+
+void BufferPool::destroy()
+{
+  //EventLoop不一定在自己的线程中析构，这里不检查线程
+  //此时已经没有线程在用这个pool，之后归还的块才可能来自不同线程
+  freeCached();
+  if (blocks_ == 0)
+  {
+    delete this;
+    return;
+  }
+  orphanRefs_.getAndSet(blocks_);
+  orphaned_ = true;
+}
+
+int BufferPool::classOf(size_t size)
+{
+  if (size <= classSize(0))
+  {
+    return 0;
+  }
+  if (size > classSize(kNumClasses - 1))
+  {
+    return kLargeClass;
+  }
+  //向上取整到2的幂
+  int shift = 64 - __builtin_clzll(static_cast<unsigned long long>(size - 1));
+  return shift - kMinShift;
+}
+
+int BufferPool::maxCachedBlocks(int sizeClass)
+{
+  assert(0 <= sizeClass && sizeClass < kNumClasses);
+  return std::max(kMinCachedBlocks, static_cast<int>(kMaxCachedBytesPerClass / classSize(sizeClass)));
+}
+
+char* BufferPool::allocate(size_t* size)
+{
+  char* block = NULL;
+  if (orphaned_)  //loop已经析构，还挂在pool上的Buffer直接malloc，不再统计
+  {
+    block = static_cast<char*>(::malloc(*size));
+    if (block == NULL)
+    {
+      abort();
+    }
+    orphanRefs_.increment();
+    return block;
+  }
+  assertInLoopThread();
+  int c = classOf(*size);
+  allocations_[c].increment();
+  inUse_[c].increment();
+  if (c == kLargeClass)
+  {
+    block = static_cast<char*>(::malloc(*size));
+  }
+  else
+  {
+    *size = classSize(c);
+    if (freeLists_[c])
+    {
+      FreeBlock* head = freeLists_[c];
+      freeLists_[c] = head->next;
+      block = reinterpret_cast<char*>(head);
+      hits_[c].increment();
+      cached_[c].decrement();
+      cachedBytes_.add(-static_cast<int64_t>(*size));
+    }
+    else
+    {
+      block = static_cast<char*>(::malloc(*size));
+    }
+  }
+  if (block == NULL)
+  {
+    abort();  // like std::bad_alloc in vector
+  }
+  inUseBytes_.add(static_cast<int64_t>(*size));
+  ++blocks_;
+  return block;
+}
+
+void BufferPool::deallocate(char* block, size_t size)
+{
+  assert(block != NULL);
+  if (orphaned_)
+  {
+    ::free(block);
+    if (orphanRefs_.decrementAndGet() == 0)
+    {
+      delete this;
+    }
+    return;
+  }
+  assertInLoopThread();
+  int c = classOf(size);
+  assert(c == kLargeClass || size == classSize(c));
+  inUse_[c].decrement();
+  inUseBytes_.add(-static_cast<int64_t>(size));
+  --blocks_;
+  if (c == kLargeClass || cached_[c].get() >= maxCachedBlocks(c))
+  {
+    ::free(block);
+  }
+  else
+  {
+    FreeBlock* head = reinterpret_cast<FreeBlock*>(block);
+    head->next = freeLists_[c];
+    freeLists_[c] = head;
+    cached_[c].increment();
+    cachedBytes_.add(static_cast<int64_t>(size));
+  }
+}
+
+void BufferPool::snapshot(Stats* stats) const
+{
+  for (int c = 0; c <= kLargeClass; ++c)
+  {
+    stats->allocations[c] = allocations_[c].get();
+    stats->hits[c] = hits_[c].get();
+    stats->inUse[c] = inUse_[c].get();
+    stats->cached[c] = cached_[c].get();
+  }
+  stats->inUseBytes = inUseBytes_.get();
+  stats->cachedBytes = cachedBytes_.get();
+}
+
+void BufferPool::trim()
+{
+  assertInLoopThread();
+  freeCached();
+}
+
+void BufferPool::freeCached()
+{
+  for (int c = 0; c < kNumClasses; ++c)
+  {
+    while (freeLists_[c])
+    {
+      FreeBlock* head = freeLists_[c];
+      freeLists_[c] = head->next;
+      ::free(head);
+      cached_[c].decrement();
+      cachedBytes_.add(-static_cast<int64_t>(classSize(c)));
+    }
+  }
+}
+
+void BufferPool::assertInLoopThread() const
+{
+  assert(threadId_ == CurrentThread::tid());
+  (void)threadId_;
+}
@@ -0,0 +1,115 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_BUFFERPOOL_H
+#define MUDUO_NET_BUFFERPOOL_H
+
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Types.h>
+#include <muduo/net/StatCounter.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <sys/types.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Storage of Buffer, one per EventLoop.
+///
+/// 大小按2的幂分级，每级一个空闲链表，释放的内存块挂回链表，下次直接复用；
+/// 每级缓存的总量有上限，超出的和大于kMaxShift的块直接free。
+/// 分配出去的内存不清零。只能在所属loop的线程中分配和释放，计数不用原子操作；
+/// 统计数字只由loop线程写，可以在任意线程读，见Inspector的/loops/buffers。
+/// EventLoop析构时用destroy()代替delete：还有没归还的块时，
+/// pool留到最后一块归还时再删除，在此之前归还的块直接free，
+/// 这时连接可能在不同线程中析构，只有这个计数是原子的。
+class BufferPool : boost::noncopyable
+{
+ public:
+  static const int kMinShift = 8;  // 256 bytes
+  static const int kMaxShift = 20;  // 1 MiB
+  static const int kNumClasses = kMaxShift - kMinShift + 1;
+  static const int kLargeClass = kNumClasses;  //统计中大块用的下标
+  static const size_t kMaxCachedBytesPerClass = 1024*1024;
+  static const int kMinCachedBlocks = 4;
+
+  BufferPool();  //在IO线程中构造
+  ~BufferPool();
+
+  /// Deletes this pool, or after the last block is returned.
+  void destroy();
+
+  /// Allocates at least @c *size bytes, not zeroed,
+  /// @c *size is set to the size actually allocated.
+  char* allocate(size_t* size);
+  /// @c size must be what allocate() returned.
+  void deallocate(char* block, size_t size);
+
+  /// Frees all cached blocks.
+  void trim();
+
+  /// Size class of @c size bytes, kLargeClass if larger than 1 << kMaxShift.
+  static int classOf(size_t size);
+  static size_t classSize(int sizeClass) { return static_cast<size_t>(1) << (sizeClass + kMinShift); }
+  static int maxCachedBlocks(int sizeClass);
+
+  struct Stats
+  {
+    int64_t allocations[kNumClasses + 1];
+    int64_t hits[kNumClasses + 1];
+    int64_t inUse[kNumClasses + 1];
+    int64_t cached[kNumClasses + 1];
+    int64_t inUseBytes;
+    int64_t cachedBytes;
+  };
+
+  /// Copies all counters, thread safe.  They are read one by one
+  /// while the loop may be changing them.
+  void snapshot(Stats* stats) const;
+
+  // 以下可在任意线程调用，sizeClass可以是kLargeClass
+  int64_t allocations(int sizeClass) const { return allocations_[sizeClass].get(); }
+  int64_t hits(int sizeClass) const { return hits_[sizeClass].get(); }  //直接从空闲链表取得的
+  int64_t inUse(int sizeClass) const { return inUse_[sizeClass].get(); }
+  int64_t cached(int sizeClass) const { return cached_[sizeClass].get(); }
+  int64_t inUseBytes() const { return inUseBytes_.get(); }
+  int64_t cachedBytes() const { return cachedBytes_.get(); }
+
+ private:
+  struct FreeBlock
+  {
+    FreeBlock* next;
+  };
+
+  void assertInLoopThread() const;
+  void freeCached();
+
+  const pid_t threadId_;
+  bool orphaned_;  //destroy()之后
+  int64_t blocks_;  //分配出去的块数，只在loop线程中访问
+  AtomicInt64 orphanRefs_;  //destroy()之后还没归还的块数，归还可能来自任意线程
+  FreeBlock* freeLists_[kNumClasses];
+
+  StatCounter allocations_[kNumClasses + 1];
+  StatCounter hits_[kNumClasses + 1];
+  StatCounter inUse_[kNumClasses + 1];
+  StatCounter cached_[kNumClasses + 1];
+  StatCounter inUseBytes_;
+  StatCounter cachedBytes_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_BUFFERPOOL_H
@@ -14,6 +14,7 @@
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <muduo/base/InplaceFunction.h>
 #include <muduo/base/Timestamp.h>
 
 namespace muduo
@@ -42,8 +43,11 @@ namespace net
 
 class Buffer;
 class TcpConnection;
+class TcpConnectionHandle;
 typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;
-typedef boost::function<void()> TimerCallback;
+// immutable payload shared by many connections, see TcpConnection::send(const SharedStringPtr&)
+typedef boost::shared_ptr<const string> SharedStringPtr;
+typedef InplaceFunction TimerCallback;
 typedef boost::function<void (const TcpConnectionPtr&)> ConnectionCallback;
 typedef boost::function<void (const TcpConnectionPtr&)> CloseCallback;
 typedef boost::function<void (const TcpConnectionPtr&)> WriteCompleteCallback;
@@ -53,6 +57,11 @@ typedef boost::function<void (const TcpConnectionPtr&, size_t)> HighWaterMarkCal
 typedef boost::function<void (const TcpConnectionPtr&,
                               Buffer*,
                               Timestamp)> MessageCallback;
+// same as MessageCallback, without touching the atomic count of TcpConnectionPtr,
+// see TcpConnectionHandle
+typedef boost::function<void (const TcpConnectionHandle&,
+                              Buffer*,
+                              Timestamp)> HandleMessageCallback;
 
 void defaultConnectionCallback(const TcpConnectionPtr& conn);
 void defaultMessageCallback(const TcpConnectionPtr& conn,
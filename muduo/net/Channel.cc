@@ -13,6 +13,7 @@
 #include <sstream>
 
 #include <poll.h>
+#include <sys/epoll.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -20,6 +21,7 @@ using namespace muduo::net;
 const int Channel::kNoneEvent = 0;//无事件
 const int Channel::kReadEvent = POLLIN | POLLPRI; // 读事件。PRI表示紧急数据，如socket的带外数据
 const int Channel::kWriteEvent = POLLOUT;//写事件
+const int Channel::kEdgeTriggered = static_cast<int>(EPOLLET);
 
 Channel::Channel(EventLoop* loop, int fd__)
   : loop_(loop),
@@ -28,6 +30,9 @@ Channel::Channel(EventLoop* loop, int fd__)
     revents_(0),
     index_(-1),
     logHup_(true),
+    edgeTriggered_(false),
+    ownerName_(NULL),
+    ownerId_(0),
     tied_(false),
     eventHandling_(false),
     addedToLoop_(false)
@@ -57,6 +62,13 @@ void Channel::update()
   loop_->updateChannel(this);
 }
 
+//只能在没有登记任何事件时切换
+void Channel::setEdgeTriggered(bool on)
+{
+  assert(isNoneEvent());
+  edgeTriggered_ = on;
+}
+
 //移除channel(调用这个函数前，确保disableAll)
 void Channel::remove()
 {
@@ -147,6 +159,8 @@ string Channel::eventsToString(int fd, int ev)
     oss << "ERR ";
   if (ev & POLLNVAL)
     oss << "NVAL ";
+  if (ev & kEdgeTriggered)
+    oss << "ET ";
 
   return oss.str().c_str();
 }
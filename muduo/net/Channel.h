@@ -78,7 +78,9 @@ class Channel : boost::noncopyable
   void tie(const boost::shared_ptr<void>&);
 
   int fd() const { return fd_; }
-  int events() const { return events_; }
+  /// Interested events, with EPOLLET if edge-triggered.
+  int events() const
+  { return edgeTriggered_ && events_ != kNoneEvent ? events_ | kEdgeTriggered : events_; }
   void set_revents(int revt) { revents_ = revt; } // used by pollers 该接口用来设置Poller需要监听Channel的哪些事件
   // int revents() const { return revents_; }
   bool isNoneEvent() const { return events_ == kNoneEvent; }
@@ -91,6 +93,11 @@ class Channel : boost::noncopyable
   bool isWriting() const { return events_ & kWriteEvent; }
   bool isReading() const { return events_ & kReadEvent; }
 
+  /// Registers with EPOLLET, only if EventLoop::supportsEdgeTriggered().
+  /// Must be called before enabling any event.
+  void setEdgeTriggered(bool on);
+  bool edgeTriggered() const { return edgeTriggered_; }
+
   // for Poller
   int index() { return index_; }
   void set_index(int idx) { index_ = idx; }
@@ -101,6 +108,14 @@ class Channel : boost::noncopyable
 
   void doNotLogHup() { logHup_ = false; }
 
+  /// Name of the owner, eg. TcpConnection::name(), printed by LoopWatchdog.
+  /// The string must outlive the channel.  A positive @c id is printed
+  /// right after it, so that the owner need not format its name.
+  void setOwnerName(const char* name, int64_t id = 0)
+  { ownerName_ = name; ownerId_ = id; }
+  const char* ownerName() const { return ownerName_; }
+  int64_t ownerId() const { return ownerId_; }
+
   EventLoop* ownerLoop() { return loop_; }
   void remove();
 
@@ -113,6 +128,7 @@ class Channel : boost::noncopyable
   static const int kNoneEvent;    //static常量定义，用“类::XX”初始化方式
   static const int kReadEvent;
   static const int kWriteEvent;
+  static const int kEdgeTriggered;  //EPOLLET
 
   EventLoop* loop_; // 属于哪一个Reactor
   const int  fd_; // 关联fd
@@ -120,6 +136,9 @@ class Channel : boost::noncopyable
   int        revents_; // it's the received event types of epoll or poll  目前的活动事件，由EventLoop/Poller设置
   int        index_; // used by Poller. 在Poller中的编号(poll事件数组的序号或epoll的通道状态)，构造函数初始化-1
   bool       logHup_;
+  bool       edgeTriggered_;  //边沿触发，只有EPollPoller支持
+  const char* ownerName_;  //所属对象的名字，可能为NULL
+  int64_t    ownerId_;  //大于0时跟在ownerName_后面
 
   boost::weak_ptr<void> tie_; // 绑定的对象,用处?
   bool tied_;  // 是否绑定了对象上来
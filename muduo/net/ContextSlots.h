@@ -0,0 +1,187 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_CONTEXTSLOTS_H
+#define MUDUO_NET_CONTEXTSLOTS_H
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <new>
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// A few typed context objects of a TcpConnection, replaces boost::any.
+///
+/// 对象就地构造在内部的一块内存中，放不下时才在堆上分配；
+/// get<T>()直接返回指针，不做typeid比较，只在debug版本中检查类型。
+/// 各个slot相互独立，例如codec用kCodecSlot，应用程序用kUserSlot。
+/// 不是线程安全的，通常只在连接所属的IO线程中使用。
+class ContextSlots : boost::noncopyable
+{
+ public:
+  enum
+  {
+    kCodecSlot,  // HttpServer, RpcServer etc.
+    kUserSlot,
+    kNumSlots = 4
+  };
+  /// Fits an HttpContext or a few shared_ptrs, keeps TcpConnection small.
+  static const size_t kInlineSize = 160;
+
+  ContextSlots()
+    : used_(0)
+  {
+  }
+
+  ~ContextSlots()
+  {
+    for (int i = 0; i < kNumSlots; ++i)
+    {
+      reset(i);
+    }
+  }
+
+  /// Copy constructs @c value into @c slot, replaces the old one.
+  template<typename T>
+  T* set(int slot, const T& value)
+  {
+    reset(slot);
+    Slot& s = slots_[checked(slot)];
+    size_t begin = inlineBegin(sizeof(T), boost::alignment_of<T>::value);
+    if (begin != kNotFit)
+    {
+      s.object = new(storage_.bytes + begin) T(value);
+      used_ = begin + sizeof(T);
+      s.inlineEnd = used_;
+    }
+    else
+    {
+      s.object = new T(value);
+    }
+    s.destroy = &destroy<T>;
+    return static_cast<T*>(s.object);
+  }
+
+  /// NULL if @c slot is empty.  T must be the type it was set with.
+  template<typename T>
+  T* get(int slot) const
+  {
+    const Slot& s = slots_[checked(slot)];
+    assert(s.object == NULL || s.destroy == &destroy<T>);
+    return static_cast<T*>(s.object);
+  }
+
+  bool empty(int slot) const
+  {
+    return slots_[checked(slot)].object == NULL;
+  }
+
+  void reset(int slot)
+  {
+    Slot& s = slots_[checked(slot)];
+    if (s.object)
+    {
+      s.destroy(s.object, s.inlineEnd == 0);
+      if (s.inlineEnd != 0 && s.inlineEnd == used_)
+      {
+        //最后分配的，退回去；否则那块内存要等所有slot都空了才能再用
+        used_ = static_cast<char*>(s.object) - storage_.bytes;
+      }
+      s.object = NULL;
+      s.destroy = NULL;
+      s.inlineEnd = 0;
+    }
+    if (used_ != 0 && allEmpty())
+    {
+      used_ = 0;
+    }
+  }
+
+ private:
+  typedef void (*Destroyer)(void* object, bool onHeap);
+
+  struct Slot
+  {
+    Slot() : object(NULL), destroy(NULL), inlineEnd(0) { }
+    void* object;
+    Destroyer destroy;  //同时用来在debug版本中检查类型
+    size_t inlineEnd;  //0表示在堆上
+  };
+
+  template<typename T>
+  static void destroy(void* object, bool onHeap)
+  {
+    T* p = static_cast<T*>(object);
+    if (onHeap)
+    {
+      delete p;
+    }
+    else
+    {
+      p->~T();
+    }
+  }
+
+  static int checked(int slot)
+  {
+    assert(0 <= slot && slot < kNumSlots);
+    return slot;
+  }
+
+  bool allEmpty() const
+  {
+    for (int i = 0; i < kNumSlots; ++i)
+    {
+      if (slots_[i].object)
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static const size_t kNotFit = static_cast<size_t>(-1);
+
+  //在内部内存中的偏移，放不下时返回kNotFit
+  size_t inlineBegin(size_t size, size_t align) const
+  {
+    if (align > boost::alignment_of<Storage>::value)
+    {
+      return kNotFit;
+    }
+    size_t begin = (used_ + align - 1) & ~(align - 1);
+    return begin + size <= kInlineSize ? begin : kNotFit;
+  }
+
+  union Storage
+  {
+    char bytes[kInlineSize];
+    long double alignLongDouble;
+    void* alignPointer;
+    long long alignLongLong;
+  };
+
+  Slot slots_[kNumSlots];
+  size_t used_;
+  Storage storage_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_CONTEXTSLOTS_H
@@ -0,0 +1,174 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/DelimiterSearch.h>
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#define MUDUO_DELIMITER_SSE2 1
+#endif
+
+// target属性里用AVX2的intrinsics需要gcc 4.9
+#if defined(__SSE2__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define MUDUO_DELIMITER_AVX2 1
+#endif
+
+using namespace muduo;
+using namespace muduo::net;
+
+const char* detail::findDelimiterScalar(const char* begin, const char* end, const char* delim, size_t len)
+{
+  size_t n = end - begin;
+  if (len == 0 || n < len)
+  {
+    return len == 0 ? begin : NULL;
+  }
+  const char* last = end - len + 1;  //可能的起点在[begin, last)中
+  const char* p = begin;
+  while (p < last)
+  {
+    p = static_cast<const char*>(memchr(p, delim[0], last - p));
+    if (p == NULL)
+    {
+      return NULL;
+    }
+    if (memcmp(p + 1, delim + 1, len - 1) == 0)
+    {
+      return p;
+    }
+    ++p;
+  }
+  return NULL;
+}
+
+namespace
+{
+
+#if MUDUO_DELIMITER_SSE2
+
+//首末字节都匹配的位置，逐个核对中间的字节
+inline const char* verify(const char* p, unsigned mask, const char* delim, size_t len)
+{
+  while (mask)
+  {
+    const char* candidate = p + __builtin_ctz(mask);
+    if (len <= 2 || memcmp(candidate + 1, delim + 1, len - 2) == 0)
+    {
+      return candidate;
+    }
+    mask &= mask - 1;
+  }
+  return NULL;
+}
+
+const char* findSse2(const char* begin, const char* end, const char* delim, size_t len)
+{
+  if (len == 0)
+  {
+    return begin;
+  }
+  const __m128i first = _mm_set1_epi8(delim[0]);
+  const __m128i last = _mm_set1_epi8(delim[len - 1]);
+  size_t n = end - begin;
+  size_t i = 0;
+  //每次看16个起点，末字节的读取不能越过end
+  for (; i + 16 + len - 1 <= n; i += 16)
+  {
+    const char* p = begin + i;
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + len - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    if (mask)
+    {
+      const char* found = verify(p, mask, delim, len);
+      if (found)
+      {
+        return found;
+      }
+    }
+  }
+  return detail::findDelimiterScalar(begin + i, end, delim, len);
+}
+
+#endif
+
+#if MUDUO_DELIMITER_AVX2
+
+__attribute__ ((target("avx2")))
+const char* findAvx2(const char* begin, const char* end, const char* delim, size_t len)
+{
+  if (len == 0)
+  {
+    return begin;
+  }
+  const __m256i first = _mm256_set1_epi8(delim[0]);
+  const __m256i last = _mm256_set1_epi8(delim[len - 1]);
+  size_t n = end - begin;
+  size_t i = 0;
+  for (; i + 32 + len - 1 <= n; i += 32)
+  {
+    const char* p = begin + i;
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + len - 1));
+    unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                                                          _mm256_cmpeq_epi8(b, last)));
+    if (mask)
+    {
+      const char* found = verify(p, mask, delim, len);
+      if (found)
+      {
+        return found;
+      }
+    }
+  }
+  return findSse2(begin + i, end, delim, len);  //剩下不到32个起点
+}
+
+#endif
+
+detail::FindDelimiterFunc selectKernel()
+{
+  detail::FindDelimiterFunc f = detail::findDelimiterAvx2();
+  if (f == NULL)
+  {
+    f = detail::findDelimiterSse2();
+  }
+  return f ? f : &detail::findDelimiterScalar;
+}
+
+}
+
+detail::FindDelimiterFunc detail::findDelimiterSse2()
+{
+#if MUDUO_DELIMITER_SSE2
+  return &findSse2;
+#else
+  return NULL;
+#endif
+}
+
+detail::FindDelimiterFunc detail::findDelimiterAvx2()
+{
+#if MUDUO_DELIMITER_AVX2
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? &findAvx2 : NULL;
+#else
+  return NULL;
+#endif
+}
+
+const char* detail::findDelimiter(const char* begin, const char* end, const char* delim, size_t len)
+{
+  static const FindDelimiterFunc kernel = selectKernel();  //第一次调用时选定
+  return kernel(begin, end, delim, len);
+}
@@ -0,0 +1,42 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_DELIMITERSEARCH_H
+#define MUDUO_NET_DELIMITERSEARCH_H
+
+#include <stddef.h>
+
+namespace muduo
+{
+namespace net
+{
+namespace detail
+{
+
+/// Finds the first @c delim of @c len bytes in [begin, end), NULL if not found.
+///
+/// 向量版本同时比较分隔符的首字节和末字节，两者都相等的位置才逐字节核对，
+/// 所以1到4个字节的分隔符(\r\n、\r\n\r\n等)几乎不会误判。
+/// findDelimiter()在第一次调用时按CPU选择AVX2、SSE2或标量版本。
+const char* findDelimiter(const char* begin, const char* end, const char* delim, size_t len);
+
+// 以下供测试用
+const char* findDelimiterScalar(const char* begin, const char* end, const char* delim, size_t len);
+typedef const char* (*FindDelimiterFunc)(const char* begin, const char* end, const char* delim, size_t len);
+/// NULL if not built in.
+FindDelimiterFunc findDelimiterSse2();
+/// NULL if not built in or not supported by this CPU.
+FindDelimiterFunc findDelimiterAvx2();
+
+}
+}
+}
+
+#endif  // MUDUO_NET_DELIMITERSEARCH_H
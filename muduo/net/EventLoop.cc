@@ -9,8 +9,11 @@
 #include <muduo/net/EventLoop.h>
 
 #include <muduo/base/Logging.h>
-#include <muduo/base/Mutex.h>
+#include <muduo/base/ThreadLocalSingleton.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/BufferPool.h>
 #include <muduo/net/Channel.h>
+#include <muduo/net/LoopStats.h>
 #include <muduo/net/Poller.h>
 #include <muduo/net/SocketsOps.h>
 #include <muduo/net/TimerQueue.h>
@@ -30,6 +33,13 @@ namespace
 __thread EventLoop* t_loopInThisThread = 0;
 
 const int kPollTimeMs = 10000;//Poll的超时时间
+const int64_t kBusyWindowMicroSeconds = Timestamp::kMicroSecondsPerSecond;  //忙碌时间的统计窗口
+const size_t kSharedReadBufferSize = 64*1024;  //见sharedReadBuffer()
+
+int64_t microSecondsBetween(Timestamp start, Timestamp end)
+{
+  return end.microSecondsSinceEpoch() - start.microSecondsSinceEpoch();
+}
 
 //创建非阻塞eventfd
 int createEventfd()
@@ -59,6 +69,39 @@ class IgnoreSigPipe
 IgnoreSigPipe initObj;//这里定义后即可忽略SIGPIPE信号
 }
 
+//pendingFunctors_链表的节点，执行完回收到freeFunctors_
+struct EventLoop::PendingFunctor
+{
+  Functor cb;
+  PendingFunctor* next;
+};
+
+//本线程从各个loop的freeFunctors_取回的节点，线程退出时释放
+struct EventLoop::NodeCache : boost::noncopyable
+{
+  NodeCache()
+    : head(NULL)
+  {
+  }
+
+  ~NodeCache()
+  {
+    deleteNodes(head);
+  }
+
+  static void deleteNodes(PendingFunctor* node)
+  {
+    while (node)
+    {
+      PendingFunctor* next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  PendingFunctor* head;
+};
+
 //返回当前线程的EventLoop对象（one loop per thread）
 EventLoop* EventLoop::getEventLoopOfCurrentThread()
 {
@@ -74,11 +117,21 @@ EventLoop::EventLoop()
     callingPendingFunctors_(false),
     iteration_(0),
     threadId_(CurrentThread::tid()),      //存储创建该对象的本线程的ID
+    bufferPool_(new BufferPool),
+    stats_(new LoopStats(this, bufferPool_)),
     poller_(Poller::newDefaultPoller(this)),  //构造了一个实际的poller对象
     timerQueue_(new TimerQueue(this)), //用于管理定时器
     wakeupFd_(createEventfd()),    //创建eventfd，用于唤醒线程用(跨线程激活,使用eventfd线程之间的通知机制)
     wakeupChannel_(new Channel(this, wakeupFd_)), //与wakeupFd_绑定
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    pendingFunctors_(NULL),
+    freeFunctors_(NULL),
+    lastPendingBatch_(0),
+    busyPollMicroSeconds_(0),
+    spins_(0),
+    idleSpins_(0),
+    busyWindowStart_(Timestamp::now()),
+    busyInWindow_(0)
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)       //检查当前线程是否创建了EventLoop对象（one loop per thread）
@@ -103,7 +156,12 @@ EventLoop::~EventLoop()
   wakeupChannel_->disableAll();
   wakeupChannel_->remove();
   ::close(wakeupFd_);
+  //没来得及执行的任务直接丢弃
+  NodeCache::deleteNodes(pendingFunctors_);
+  NodeCache::deleteNodes(freeFunctors_);
   t_loopInThisThread = NULL;
+  stats_.reset();  //先从Inspector能遍历到的列表中去掉，它会读bufferPool_
+  bufferPool_->destroy();  //连接晚于loop析构时，要等它们的Buffer都还回来
 }
 
 //loop()函数中当poll()返回时，会遍历活跃通道表activeChannels，
@@ -116,36 +174,115 @@ void EventLoop::loop()
   quit_ = false;  // FIXME: what if someone calls quit() before loop() ?
   LOG_TRACE << "EventLoop " << this << " start looping";
 
+  Timestamp iterationEnd(Timestamp::now());
   while (!quit_)
   {
     activeChannels_.clear(); //首先清除上一次的活跃channel
-    pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_); //使用epoll_wait等待事件到来，并把到来的事件填充至activeChannels
+    int timeoutMs = pollTimeoutMs();
+    pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_); //使用epoll_wait等待事件到来，并把到来的事件填充至activeChannels
     ++iteration_;
+    stats_->recordPoll(microSecondsBetween(iterationEnd, pollReturnTime_));
+    if (!activeChannels_.empty())
+    {
+      lastActiveTime_ = pollReturnTime_;
+    }
+    else if (timeoutMs == 0 && busyPollMicroSeconds_ > 0)
+    {
+      ++idleSpins_;
+    }
     if (Logger::logLevel() <= Logger::TRACE)
     {
       printActiveChannels();  //日志登记，日志打印
     }
     // TODO sort channel by priority
     eventHandling_ = true;
-    //逐一取出活动的事件列表，并执行相关回调函数
+    //逐一取出活动的事件列表，并执行相关回调函数，每个回调前后各取一次时间
+    Timestamp handlerStart = pollReturnTime_;
     for (ChannelList::iterator it = activeChannels_.begin();
         it != activeChannels_.end(); ++it)
     {
       currentActiveChannel_ = *it;//当前正在处理的活动通道
+      int fd = currentActiveChannel_->fd();
+      stats_->enterCallback(LoopStats::kChannel, currentActiveChannel_, NULL,
+                            handlerStart.microSecondsSinceEpoch());
       currentActiveChannel_->handleEvent(pollReturnTime_);
+      stats_->leaveCallback();
+      Timestamp handlerEnd(Timestamp::now());
+      stats_->recordChannel(fd, microSecondsBetween(handlerStart, handlerEnd));
+      handlerStart = handlerEnd;
     }
     currentActiveChannel_ = NULL;  //处理完了赋空
     eventHandling_ = false;
 
     // 执行pending Functors_中的任务回调
     // 这种设计使得IO线程也能执行一些计算任务，避免了IO线程在不忙时长期阻塞在IO multiplexing调用中
+    if (!deferredFunctors_.empty())
+    {
+      stats_->enterCallback(LoopStats::kDeferred, NULL, NULL, handlerStart.microSecondsSinceEpoch());
+      doDeferredFunctors();  //新就绪的channel先处理，再轮到上一轮推迟的
+      stats_->leaveCallback();
+      Timestamp deferredEnd(Timestamp::now());
+      stats_->recordDeferred(microSecondsBetween(handlerStart, deferredEnd));
+    }
     doPendingFunctors(); 
+    iterationEnd = Timestamp::now();
+    updateBusyTime(iterationEnd);
   }
 
   LOG_TRACE << "EventLoop " << this << " stop looping";
   looping_ = false;
 }
 
+//有推迟的任务时不阻塞，只看看这期间又有哪些channel就绪了；
+//忙轮询时，最后一次有事件之后的busyPollMicroSeconds_内也不阻塞，省掉线程被唤醒的延迟
+int EventLoop::pollTimeoutMs()
+{
+  if (!deferredFunctors_.empty())
+  {
+    return 0;
+  }
+  if (busyPollMicroSeconds_ > 0
+      && pollReturnTime_.microSecondsSinceEpoch() - lastActiveTime_.microSecondsSinceEpoch()
+         < busyPollMicroSeconds_)
+  {
+    ++spins_;
+    return 0;
+  }
+  return kPollTimeMs;
+}
+
+void EventLoop::setBusyPoll(int spinMicroSeconds)
+{
+  assertInLoopThread();
+  assert(spinMicroSeconds >= 0);
+  busyPollMicroSeconds_ = spinMicroSeconds;
+  lastActiveTime_ = Timestamp::now();
+}
+
+//poll返回到本轮处理完之间的时间算作忙碌，按一秒的窗口汇总后发布给其他线程
+void EventLoop::updateBusyTime(Timestamp now)
+{
+  busyInWindow_ += now.microSecondsSinceEpoch() - pollReturnTime_.microSecondsSinceEpoch();
+  if (now.microSecondsSinceEpoch() - busyWindowStart_.microSecondsSinceEpoch() >= kBusyWindowMicroSeconds)
+  {
+    recentBusy_.getAndSet(busyInWindow_);
+    recentBusyEnd_.getAndSet(now.microSecondsSinceEpoch());
+    busyWindowStart_ = now;
+    busyInWindow_ = 0;
+  }
+}
+
+int64_t EventLoop::recentBusyMicroSeconds() const
+{
+  // 一直阻塞在poll中的loop不会更新窗口，上次的统计已经过时，它其实是空闲的
+  int64_t end = recentBusyEnd_.get();
+  if (Timestamp::now().microSecondsSinceEpoch() - end > 2 * kBusyWindowMicroSeconds)
+  {
+    return 0;
+  }
+  return recentBusy_.get();
+}
+
 //结束循环.可跨线程调用
 void EventLoop::quit()
 {
@@ -175,11 +312,36 @@ void EventLoop::runInLoop(const Functor& cb)
 //将任务放到pendingFunctors_队列中并通过evnetfd唤醒IO线程执行任务
 void EventLoop::queueInLoop(const Functor& cb)  
 {
-  // 把任务加入到队列可能同时被多个线程调用，需要加锁
+  PendingFunctor* node = newPendingFunctor();
+  node->cb = cb;
+  pushPendingFunctor(node);
+}
+
+EventLoop::PendingFunctor* EventLoop::newPendingFunctor()
+{
+  NodeCache& cache = ThreadLocalSingleton<NodeCache>::instance();
+  if (cache.head == NULL && freeFunctors_ != NULL)
   {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(cb); //把回调函数加入到队列当中
+    cache.head = __sync_lock_test_and_set(&freeFunctors_, static_cast<PendingFunctor*>(NULL));
   }
+  PendingFunctor* node = cache.head;
+  if (node)
+  {
+    cache.head = node->next;
+    return node;
+  }
+  return new PendingFunctor;
+}
+
+// 把任务加入到队列可能同时被多个线程调用，用CAS把节点压到链表头，不加锁
+void EventLoop::pushPendingFunctor(PendingFunctor* node)
+{
+  PendingFunctor* head = NULL;
+  do
+  {
+    head = pendingFunctors_;
+    node->next = head;
+  } while (!__sync_bool_compare_and_swap(&pendingFunctors_, head, node));
 
   // 将cb放入队列后，我们还需要唤醒IO线程来及时执行Functor
   // 有两种情况：
@@ -189,17 +351,18 @@ void EventLoop::queueInLoop(const Functor& cb)
   //    循环回去到poll的时候需要被唤醒进而继续执行doPendingFunctors()，否则新增的cb可能不能及时被调用),
   // 即只有在IO线程的事件回调中调用queueInLoop()才无需唤醒(即在handleEvent()中调用queueInLoop ()不需要唤醒
   //    ，因为接下来马上就会执行doPendingFunctors())
-  if (!isInLoopThread() || callingPendingFunctors_) 
+  // 本轮已经有线程唤醒过了就不用再写eventfd，doPendingFunctors()取走任务前会清除wakeupPending_
+  if ((!isInLoopThread() || callingPendingFunctors_)
+      && wakeupPending_.getAndSet(1) == 0)
   {
     wakeup(); //写一个字节来唤醒poll阻塞，触发wakeupFd可读事件
   }
 }
 
-//返回任务队列pendingFunctors_大小
-size_t EventLoop::queueSize() const
+//上一轮doPendingFunctors()取走的任务数，提交任务的线程不计数
+size_t EventLoop::lastBatchSize() const
 {
-  MutexLockGuard lock(mutex_);
-  return pendingFunctors_.size();
+  return static_cast<size_t>(__atomic_load_n(&lastPendingBatch_, __ATOMIC_RELAXED));
 }
 
 //某个时间点执行定时回调
@@ -238,15 +401,9 @@ void EventLoop::runInLoop(Functor&& cb)
 
 void EventLoop::queueInLoop(Functor&& cb)
 {
-  {
-  MutexLockGuard lock(mutex_);
-  pendingFunctors_.push_back(std::move(cb));  // emplace_back
-  }
-
-  if (!isInLoopThread() || callingPendingFunctors_)
-  {
-    wakeup();
-  }
+  PendingFunctor* node = newPendingFunctor();
+  node->cb = std::move(cb);
+  pushPendingFunctor(node);
 }
 
 TimerId EventLoop::runAt(const Timestamp& time, TimerCallback&& cb)
@@ -273,6 +430,12 @@ void EventLoop::cancel(TimerId timerId)
   return timerQueue_->cancel(timerId);
 }
 
+void EventLoop::setTimingWheel(double tick, int numSlots)
+{
+  assertInLoopThread();
+  timerQueue_->setTimingWheel(tick, numSlots);
+}
+
 //更新通道,将channel对应的fd事件注册或更改到epoll内核事件表中
 void EventLoop::updateChannel(Channel* channel)
 {
@@ -301,6 +464,22 @@ bool EventLoop::hasChannel(Channel* channel)
   return poller_->hasChannel(channel);
 }
 
+bool EventLoop::supportsEdgeTriggered() const
+{
+  return poller_->supportsEdgeTriggered();
+}
+
+Buffer* EventLoop::sharedReadBuffer()
+{
+  assertInLoopThread();
+  if (!sharedReadBuffer_)
+  {
+    //一次能读完一个64k的突发，不必再用Buffer::readFd()栈上的extrabuf
+    sharedReadBuffer_.reset(new Buffer(kSharedReadBufferSize));
+  }
+  return get_pointer(sharedReadBuffer_);
+}
+
 //不在IO线程,则退出程序
 void EventLoop::abortNotInLoopThread()
 {
@@ -335,25 +514,84 @@ void EventLoop::handleRead()
 //执行pendingFunctors_中的任务
 void EventLoop::doPendingFunctors()
 {
-  std::vector<Functor> functors;
   callingPendingFunctors_ = true; //设置标志位,表示当前在执行Functors任务
 
-  //好！swap到局部变量中，再下面回调！
-  //好处：１.缩减临界区长度,意味这不会阻塞其他线程调用queueInLoop
+  //先清除wakeupPending_再取走链表，之后压入的任务会重新唤醒IO线程
+  wakeupPending_.getAndSet(0);
+
+  //好！一次把整个链表取下来，再下面回调！
+  //好处：１.不会阻塞其他线程调用queueInLoop
   //       2.避免死锁(因为Functor可能再调用queueInLoop)
+  PendingFunctor* node = __sync_lock_test_and_set(&pendingFunctors_, static_cast<PendingFunctor*>(NULL));
+
+  //链表头是最后压入的，反转成提交顺序
+  PendingFunctor* functors = NULL;
+  int64_t count = 0;
+  while (node)
   {
-  MutexLockGuard lock(mutex_);
-  functors.swap(pendingFunctors_);
+    PendingFunctor* next = node->next;
+    node->next = functors;
+    functors = node;
+    node = next;
+    ++count;
+  }
+  __atomic_store_n(&lastPendingBatch_, count, __ATOMIC_RELAXED);  //只有IO线程写
+  if (count > 0)
+  {
+    stats_->recordPendingBatch(count);
+  }
+
+  //依次执行functors，执行完的节点清空后留在原来的链表上
+  Timestamp start = functors ? Timestamp::now() : Timestamp();
+  PendingFunctor* last = NULL;
+  for (PendingFunctor* f = functors; f; f = f->next)
+  {
+    const char* name = f->cb.target_type().name();
+    stats_->enterCallback(LoopStats::kPendingFunctor, NULL, name, start.microSecondsSinceEpoch());
+    f->cb();
+    stats_->leaveCallback();
+    Timestamp end(Timestamp::now());
+    stats_->recordPendingFunctor(name, microSecondsBetween(start, end));
+    start = end;
+    f->cb.clear();  //及时释放绑定的对象
+    last = f;
   }
 
-  //依次执行functors
-  for (size_t i = 0; i < functors.size(); ++i)
+  //整串还给freeFunctors_
+  if (last)
   {
-    functors[i]();
+    PendingFunctor* head = NULL;
+    do
+    {
+      head = freeFunctors_;
+      last->next = head;
+    } while (!__sync_bool_compare_and_swap(&freeFunctors_, head, functors));
   }
   callingPendingFunctors_ = false;
 }
 
+void EventLoop::queueDeferred(const Functor& cb)
+{
+  assertInLoopThread();
+  deferredFunctors_.push_back(cb);
+}
+
+void EventLoop::doDeferredFunctors()
+{
+  if (deferredFunctors_.empty())
+  {
+    return;
+  }
+  //执行中再推迟的留到下一轮；两个vector轮换，容量留着下次用
+  assert(runningDeferred_.empty());
+  runningDeferred_.swap(deferredFunctors_);
+  for (size_t i = 0; i < runningDeferred_.size(); ++i)
+  {
+    runningDeferred_[i]();
+  }
+  runningDeferred_.clear();  //及时释放绑定的对象
+}
+
 void EventLoop::printActiveChannels() const
 {
   for (ChannelList::const_iterator it = activeChannels_.begin();
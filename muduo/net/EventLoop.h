@@ -14,12 +14,13 @@
 #include <vector>
 
 #include <boost/any.hpp>
-#include <boost/function.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <muduo/base/Atomic.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/CurrentThread.h>
+#include <muduo/base/InplaceFunction.h>
 #include <muduo/base/Timestamp.h>
 #include <muduo/net/Callbacks.h>
 #include <muduo/net/TimerId.h>
@@ -29,7 +30,9 @@ namespace muduo
 namespace net
 {
 
+class BufferPool;
 class Channel;
+class LoopStats;
 class Poller;
 class TimerQueue;
 
@@ -40,7 +43,7 @@ class TimerQueue;
 class EventLoop : boost::noncopyable
 {
  public:
-  typedef boost::function<void()> Functor;
+  typedef InplaceFunction Functor;  //小的函数对象就地存放，跨线程投递不再为它分配内存
 
   EventLoop();
   ~EventLoop();  // force out-line dtor, for scoped_ptr members.
@@ -65,6 +68,28 @@ class EventLoop : boost::noncopyable
 
   int64_t iteration() const { return iteration_; }//迭代次数
 
+  // load counters, safe to read from other threads, see EventLoopThreadPool::LoadBalance
+
+  /// Number of TcpConnection created in this loop and not yet destroyed.
+  int numConnections() const { return numConnections_.get(); }
+  /// Microseconds spent handling events and pending functors
+  /// during the last whole second the loop was active.
+  int64_t recentBusyMicroSeconds() const;
+
+  ///
+  /// Busy polling for latency-critical loops: after the last active poll,
+  /// keeps polling with zero timeout for @c spinMicroSeconds before
+  /// blocking again, and sets SO_BUSY_POLL on new connections of this loop.
+  /// 0 (default) disables it.
+  /// Must be called in the loop thread, eg. in EventLoopThread::ThreadInitCallback.
+  ///
+  void setBusyPoll(int spinMicroSeconds);
+  int busyPollMicroSeconds() const { return busyPollMicroSeconds_; }
+  /// Number of zero-timeout polls made by busy polling.
+  int64_t spins() const { return spins_; }
+  /// Number of those polls which found nothing to do, for tuning spinMicroSeconds.
+  int64_t idleSpins() const { return idleSpins_; }
+
   /// Runs callback immediately in the loop thread.
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
@@ -74,10 +99,19 @@ class EventLoop : boost::noncopyable
   void runInLoop(const Functor& cb);
   /// Queues callback in the loop thread.
   /// Runs after finish pooling.
-  /// Safe to call from other threads.
+  /// Safe to call from other threads, lock-free,
+  /// at most one wakeup() per loop iteration however many threads call it.
   void queueInLoop(const Functor& cb);  //将任务放到pendingFunctors_队列中并通过evnetfd唤醒IO线程执行任务
 
-  size_t queueSize() const;//返回任务队列pendingFunctors_大小
+  /// Number of functors the loop took in its last round, not the live queue
+  /// depth, producers do not count so queueInLoop() stays a single CAS.
+  size_t lastBatchSize() const;
+
+  /// Runs callback in the next iteration, after a poll with zero timeout,
+  /// so channels which become ready meanwhile go first.
+  /// For work that used up its budget, eg. TcpConnection::setReadBudget().
+  /// Must be called in the loop thread.
+  void queueDeferred(const Functor& cb);
 
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
   void runInLoop(Functor&& cb);
@@ -107,6 +141,14 @@ class EventLoop : boost::noncopyable
   ///
   void cancel(TimerId timerId);//删除timerId对应的定时器
 
+  ///
+  /// Keeps timers in a hashed timing wheel of @c tick seconds,
+  /// runAt()/runAfter()/cancel() become O(1), for millions of timeouts.
+  /// Timers fire up to one tick late.
+  /// Must be called in the loop thread, before adding any timer.
+  ///
+  void setTimingWheel(double tick, int numSlots = 4096);
+
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
   TimerId runAt(const Timestamp& time, TimerCallback&& cb);
   TimerId runAfter(double delay, TimerCallback&& cb);
@@ -114,10 +156,18 @@ class EventLoop : boost::noncopyable
 #endif
 
   // internal usage
+  void connectionCreated() { numConnections_.increment(); }  //TcpConnection构造时调用，线程安全
+  void connectionDestroyed() { numConnections_.decrement(); }  //TcpConnection::connectDestroyed()调用
   void wakeup();//写8个字节给eventfd，唤醒事件通知描述符。否则EventLoop::loop()的poll会阻塞
   void updateChannel(Channel* channel); //在poller中注册或者更新通道
   void removeChannel(Channel* channel); //从poller中移除通道
   bool hasChannel(Channel* channel);
+  bool supportsEdgeTriggered() const;  //只有epoll支持EPOLLET
+  LoopStats* stats() { return stats_.get(); }  //各阶段耗时，见Inspector的/loops/stats
+  /// Internal use only, see TcpConnection::setSharedReadBuffer().
+  Buffer* sharedReadBuffer();
+  /// Storage of connection buffers, only used in the loop thread.
+  BufferPool* bufferPool() { return bufferPool_; }
 
   // pid_t threadId() const { return threadId_; }
   void assertInLoopThread() //断言处于当前线程中（主要是因为有些接口不能跨线程调用）
@@ -148,6 +198,14 @@ class EventLoop : boost::noncopyable
   void abortNotInLoopThread();//不在IO线程,则退出程序
   void handleRead();   //将eventfd里的内容读走，以便让其继续检测事件通知
   void doPendingFunctors();//执行pendingFunctors_中的任务
+  void doDeferredFunctors();  //执行上一轮推迟的任务
+  void updateBusyTime(Timestamp now);  //每次循环结束时累计忙碌时间
+  int pollTimeoutMs();  //本轮poll的超时时间
+
+  struct PendingFunctor;
+  struct NodeCache;
+  PendingFunctor* newPendingFunctor();  //优先用回收的节点
+  void pushPendingFunctor(PendingFunctor* node);  //无锁地把任务压入pendingFunctors_
 
   void printActiveChannels() const; // DEBUG
 
@@ -160,6 +218,8 @@ class EventLoop : boost::noncopyable
   int64_t iteration_; //poll返回的次数
   const pid_t threadId_;    //EventLoop构造函数会记住本对象所属的线程ID
   Timestamp pollReturnTime_;  //poll返回的时间戳
+  BufferPool* const bufferPool_;  //析构函数中调用destroy()
+  boost::scoped_ptr<LoopStats> stats_;  //在poller_之前构造
   boost::scoped_ptr<Poller> poller_;  //EventLoop首先一定得有个I/O复用才行,它的所有职责都是建立在I/O复用之上的
   boost::scoped_ptr<TimerQueue> timerQueue_;  //应该支持定时事件，关于定时器的所有操作和组织定义都在类TimerQueue中 
   int wakeupFd_; //用于eventfd的通知机制的文件描述符
@@ -167,13 +227,34 @@ class EventLoop : boost::noncopyable
   // we don't expose Channel to client.
   boost::scoped_ptr<Channel> wakeupChannel_;  //wakeupFd_对于的通道。若此事件发生便会一次执行pendingFunctors_中的可调用对象
   boost::any context_;  //用来存储用户想要保存的信息，boost::any任何类型的数据都可以
+  boost::scoped_ptr<Buffer> sharedReadBuffer_;  //本loop中的连接共用，第一次用到时才分配
 
   // scratch variables
   ChannelList activeChannels_;  //保存的是poller类中的poll调用返回的所有活跃事件集
   Channel* currentActiveChannel_; //当前正在处理的活动通道
 
-  mutable MutexLock mutex_;
-  std::vector<Functor> pendingFunctors_; // @GuardedBy mutex_
+  //多生产者单消费者的无锁链表，新任务用CAS压在链表头，
+  //IO线程一次取走整个链表，反转后按提交顺序执行
+  PendingFunctor* volatile pendingFunctors_;
+  //执行完的节点，只由IO线程整串压入，提交任务的线程一次全部取走，没有ABA问题
+  PendingFunctor* volatile freeFunctors_;
+  int64_t lastPendingBatch_;  //上一次取走的任务数，IO线程relaxed写，lastBatchSize()读
+  AtomicInt32 wakeupPending_;  //已写过wakeupFd_且IO线程还没开始处理，不必再写
+  std::vector<Functor> deferredFunctors_;  //用完预算的任务，下一轮poll之后再执行，只在IO线程中访问
+  std::vector<Functor> runningDeferred_;  //正在执行的那批，和deferredFunctors_交换，保留容量
+
+  // 忙轮询，只在IO线程中访问
+  int busyPollMicroSeconds_;  //最后一次有事件之后继续空转的时间，0表示不空转
+  Timestamp lastActiveTime_;  //最后一次poll返回活跃channel的时间
+  int64_t spins_;  //超时为0的空转poll次数
+  int64_t idleSpins_;  //其中什么都没等到的次数
+
+  // 负载计数，供其他线程选择loop时读取
+  mutable AtomicInt32 numConnections_;
+  Timestamp busyWindowStart_;  //当前统计窗口的起点，只在IO线程中访问
+  int64_t busyInWindow_;  //当前窗口累计的忙碌微秒数，只在IO线程中访问
+  mutable AtomicInt64 recentBusy_;  //上一个完整窗口的忙碌微秒数
+  mutable AtomicInt64 recentBusyEnd_;  //上一个完整窗口结束的时间，微秒
 };                  //当非io线程(搭载EventLoop的线程)想使某个任务放在io线程中来执行，
                     //那么就可以将其放到数据成员pendingFunctors_中来
                     //其对应的事件便是wakeupChannel_事件
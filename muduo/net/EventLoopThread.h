@@ -39,6 +39,12 @@ class EventLoopThread : boost::noncopyable
   ~EventLoopThread();
   EventLoop* startLoop(); //启动线程，该线程就成为了IO线程 ，返回本线程中的EventLoop
 
+  /// Pins the IO thread to @c cpu before its EventLoop is created.
+  /// Must be called before startLoop(), usually with EventLoop::setBusyPoll().
+  void setCpuAffinity(int cpu) { thread_.setCpuAffinity(std::vector<int>(1, cpu)); }
+  /// Runs the IO thread on these CPUs, see CpuAffinity.
+  void setCpuAffinity(const std::vector<int>& cpus) { thread_.setCpuAffinity(cpus); }
+
  private:
   void threadFunc();  //线程函数
 
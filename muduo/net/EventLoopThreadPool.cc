@@ -14,6 +14,7 @@
 #include <boost/bind.hpp>
 
 #include <stdio.h>
+#include <stdlib.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -24,7 +25,9 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const string& name
     name_(nameArg),
     started_(false),
     numThreads_(0),
-    next_(0)
+    next_(0),
+    policy_(kRoundRobin),
+    seed_(static_cast<unsigned int>(reinterpret_cast<uintptr_t>(this)))
 {
 }
 
@@ -48,6 +51,7 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     char buf[name_.size() + 32];
     snprintf(buf, sizeof buf, "%s%d", name_.c_str(), i);
     EventLoopThread* t = new EventLoopThread(cb, buf); //创建EventLoop IO线程
+    t->setCpuAffinity(affinity_.cpusOf(i));  //先绑定CPU，EventLoop和它的Buffer都从本地NUMA节点分配
     threads_.push_back(t);//当ptr_vector<EventLoopThread>对象销毁，其所管理的EventLoopThread也跟着销毁
     loops_.push_back(t->startLoop()); // startLoop()会创建并返回运行的EventLoop,然后push_back到loops_
   }
@@ -64,20 +68,85 @@ EventLoop* EventLoopThreadPool::getNextLoop()
 {
   baseLoop_->assertInLoopThread();
   assert(started_);
-  EventLoop* loop = baseLoop_;/* baseLoop_是Acceptor所属EventLoop，即mainReactor*/
 
   // 如果loops_为空，则loop指向baseLoop_ 所有任务由mainReactor处理
-  // 如果不为空，按照round-robin（RR，轮叫）的调度方式选择一个EventLoop
-  if (!loops_.empty())
+  // 如果不为空，按照policy_选择一个EventLoop
+  if (loops_.empty())
+  {
+    return baseLoop_;  /* baseLoop_是Acceptor所属EventLoop，即mainReactor*/
+  }
+
+  switch (policy_)
+  {
+    case kLeastConnections:
+      return getLeastConnections();
+    case kLeastBusy:
+      return getPowerOfTwoChoices(true);
+    case kPowerOfTwoChoices:
+      return getPowerOfTwoChoices(false);
+    default:
+      return getNextLoopRoundRobin();
+  }
+}
+
+// round-robin（RR，轮叫）
+EventLoop* EventLoopThreadPool::getNextLoopRoundRobin()
+{
+  EventLoop* loop = loops_[next_];
+  ++next_;
+  if (implicit_cast<size_t>(next_) >= loops_.size())
+  {
+    next_ = 0;
+  }
+  return loop;
+}
+
+// 从next_开始扫描，连接数相同时轮流分配，而不是总落在第一个loop上
+EventLoop* EventLoopThreadPool::getLeastConnections()
+{
+  size_t n = loops_.size();
+  size_t best = next_;
+  int bestLoad = 0;
+  for (size_t i = 0; i < n; ++i)
   {
-    loop = loops_[next_];
-    ++next_;
-    if (implicit_cast<size_t>(next_) >= loops_.size())
+    size_t idx = (next_ + i) % n;
+    int load = loops_[idx]->numConnections();
+    if (i == 0 || load < bestLoad)
     {
-      next_ = 0;
+      best = idx;
+      bestLoad = load;
     }
   }
-  return loop;
+  next_ = static_cast<int>((best + 1) % n);
+  return loops_[best];
+}
+
+// 随机挑两个loop取负载轻的，不用看全部loop的计数，也不会让一批新连接都涌向同一个loop。
+// 忙碌时间每秒才更新一次，这一秒内新来的连接如果都按它挑最闲的loop，会全部涌过去，
+// 所以它也只在随机的两个之间比较，相同时再比连接数。
+EventLoop* EventLoopThreadPool::getPowerOfTwoChoices(bool byBusyTime)
+{
+  size_t n = loops_.size();
+  if (n == 1)
+  {
+    return loops_[0];
+  }
+  size_t a = static_cast<size_t>(rand_r(&seed_)) % n;
+  size_t b = static_cast<size_t>(rand_r(&seed_)) % (n - 1);
+  if (b >= a)
+  {
+    ++b;  //b != a
+  }
+  if (byBusyTime)
+  {
+    int64_t busyA = loops_[a]->recentBusyMicroSeconds();
+    int64_t busyB = loops_[b]->recentBusyMicroSeconds();
+    if (busyA != busyB)
+    {
+      return busyA < busyB ? loops_[a] : loops_[b];
+    }
+  }
+  return loops_[a]->numConnections() <= loops_[b]->numConnections() ? loops_[a] : loops_[b];
 }
 
 //指定某一个loop，强制获取
@@ -11,6 +11,7 @@
 #ifndef MUDUO_NET_EVENTLOOPTHREADPOOL_H
 #define MUDUO_NET_EVENTLOOPTHREADPOOL_H
 
+#include <muduo/base/CpuAffinity.h>
 #include <muduo/base/Types.h>
 
 #include <vector>
@@ -34,13 +35,25 @@ class EventLoopThreadPool : boost::noncopyable
  public:
   typedef boost::function<void(EventLoop*)> ThreadInitCallback;
 
+  /// How getNextLoop() picks a loop for a new connection.
+  enum LoadBalance
+  {
+    kRoundRobin,  //轮流，默认
+    kLeastConnections,  //连接数最少的loop
+    kLeastBusy,  //随机挑两个，取最近一秒忙碌时间短的，相同时取连接数少的
+    kPowerOfTwoChoices,  //随机挑两个，取连接数少的那个
+  };
+
   EventLoopThreadPool(EventLoop* baseLoop, const string& nameArg);
   ~EventLoopThreadPool();
   void setThreadNum(int numThreads) { numThreads_ = numThreads; } //设置开启loop循环的线程数量
+  void setLoadBalance(LoadBalance policy) { policy_ = policy; }
+  /// Where the IO threads run, must be called before start().
+  void setCpuAffinity(const CpuAffinity& affinity) { affinity_ = affinity; }
   void start(const ThreadInitCallback& cb = ThreadInitCallback());  //启动各个loop线程
 
   // valid after calling start()
-  /// round-robin
+  /// round-robin by default, see setLoadBalance()
   EventLoop* getNextLoop(); //获得loops_中的下一个EventLoop地址
 
   /// with the same hash code, it will always return the same EventLoop
@@ -55,12 +68,18 @@ class EventLoopThreadPool : boost::noncopyable
   { return name_; }
 
  private:
+  EventLoop* getNextLoopRoundRobin();
+  EventLoop* getLeastConnections();  //线性扫描，IO线程数不会很多
+  EventLoop* getPowerOfTwoChoices(bool byBusyTime);
 
   EventLoop* baseLoop_; /* baseLoop_是Acceptor所属EventLoop，即mainReactor*/
   string name_;
   bool started_;
   int numThreads_;  //表示创建多少个loop线程
   int next_;  //新连接到来的loops_的下标
+  LoadBalance policy_;
+  CpuAffinity affinity_;  //IO线程绑定的CPU
+  unsigned int seed_;  //kPowerOfTwoChoices和kLeastBusy的随机数种子，只在baseLoop_线程中使用
   boost::ptr_vector<EventLoopThread> threads_;  //IO线程列表,当ptr_vector对象销毁，其所管理的EventLoopThread也跟着销毁
   std::vector<EventLoop*> loops_; //EventLoop*列表,即为EventLoop*池
 };
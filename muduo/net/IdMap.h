@@ -0,0 +1,198 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_IDMAP_H
+#define MUDUO_NET_IDMAP_H
+
+#include <muduo/base/Types.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Hash map from positive 64-bit id to T, open addressing with linear probing.
+///
+/// 连续分配的id用斐波那契散列打散；删除时把后面的元素往回挪(backward shift)，
+/// 没有墓碑，插入删除都不分配内存，只在扩容时重新散列。
+/// 负载因子不超过1/2。不是线程安全的。
+template<typename T>
+class IdMap
+{
+ public:
+  IdMap()
+    : slots_(kInitialCapacity),
+      size_(0)
+  {
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /// Returns false if @c id exists.
+  bool insert(int64_t id, const T& value)
+  {
+    assert(id > 0);
+    if ((size_ + 1) * 2 > slots_.size())
+    {
+      grow();
+    }
+    size_t i = slotOf(id);
+    while (slots_[i].id != kEmpty)
+    {
+      if (slots_[i].id == id)
+      {
+        return false;
+      }
+      i = next(i);
+    }
+    slots_[i].id = id;
+    slots_[i].value = value;
+    ++size_;
+    return true;
+  }
+
+  /// NULL if not found.
+  T* find(int64_t id)
+  {
+    size_t i = indexOf(id);
+    return i == kNotFound ? NULL : &slots_[i].value;
+  }
+
+  size_t erase(int64_t id)
+  {
+    size_t i = indexOf(id);
+    if (i == kNotFound)
+    {
+      return 0;
+    }
+    //后面同一簇中能放到空位的元素往回挪，保证查找时不会提前遇到空槽
+    size_t j = i;
+    while (true)
+    {
+      j = next(j);
+      if (slots_[j].id == kEmpty)
+      {
+        break;
+      }
+      size_t home = slotOf(slots_[j].id);
+      bool between = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+      if (!between)
+      {
+        slots_[i].id = slots_[j].id;
+        std::swap(slots_[i].value, slots_[j].value);  //要删除的值跟着挪到j
+        i = j;
+      }
+    }
+    slots_[i].id = kEmpty;
+    slots_[i].value = T();
+    --size_;
+    return 1;
+  }
+
+  /// Moves all values out, and clears the map.
+  void takeAll(std::vector<T>* values)
+  {
+    values->reserve(values->size() + size_);
+    for (size_t i = 0; i < slots_.size(); ++i)
+    {
+      if (slots_[i].id != kEmpty)
+      {
+        values->push_back(T());
+        std::swap(values->back(), slots_[i].value);
+        slots_[i].id = kEmpty;
+      }
+    }
+    size_ = 0;
+  }
+
+  void swap(IdMap& that)
+  {
+    slots_.swap(that.slots_);
+    std::swap(size_, that.size_);
+  }
+
+ private:
+  static const int64_t kEmpty = 0;
+  static const size_t kInitialCapacity = 64;
+  static const size_t kNotFound = static_cast<size_t>(-1);
+
+  struct Slot
+  {
+    Slot() : id(kEmpty) { }
+    int64_t id;
+    T value;
+  };
+
+  size_t next(size_t i) const { return (i + 1) & (slots_.size() - 1); }
+
+  size_t slotOf(int64_t id) const
+  {
+    //乘以2^64/黄金分割比，取高位
+    uint64_t h = static_cast<uint64_t>(id) * 11400714819323198485ULL;
+    return static_cast<size_t>(h >> (64 - log2Capacity())) & (slots_.size() - 1);
+  }
+
+  int log2Capacity() const { return __builtin_ctzll(slots_.size()); }
+
+  size_t indexOf(int64_t id) const
+  {
+    if (id <= 0)
+    {
+      return kNotFound;
+    }
+    size_t i = slotOf(id);
+    while (slots_[i].id != kEmpty)
+    {
+      if (slots_[i].id == id)
+      {
+        return i;
+      }
+      i = next(i);
+    }
+    return kNotFound;
+  }
+
+  void grow()
+  {
+    std::vector<Slot> old(slots_.size() * 2);
+    old.swap(slots_);
+    size_ = 0;
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+      if (old[i].id != kEmpty)
+      {
+        size_t j = slotOf(old[i].id);
+        while (slots_[j].id != kEmpty)
+        {
+          j = next(j);
+        }
+        slots_[j].id = old[i].id;
+        std::swap(slots_[j].value, old[i].value);
+        ++size_;
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;  //容量总是2的幂
+  size_t size_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_IDMAP_H
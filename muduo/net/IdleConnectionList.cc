@@ -0,0 +1,172 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/IdleConnectionList.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/base/WeakCallback.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpConnection.h>
+
+#include <algorithm>
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+IdleConnectionList::IdleConnectionList(EventLoop* loop, double idleSeconds, double releaseSeconds)
+  : loop_(loop),
+    idleSeconds_(idleSeconds),
+    releaseSeconds_(releaseSeconds),
+    head_(NULL),
+    tail_(NULL),
+    releasedTail_(NULL),
+    size_(0)
+{
+  assert(idleSeconds > 0 || releaseSeconds > 0);
+}
+
+void IdleConnectionList::start()
+{
+  //最多晚一秒踢掉空闲连接；定时器只持有弱引用
+  double interval = 1.0;
+  if (idleSeconds_ > 0)
+  {
+    interval = std::min(interval, idleSeconds_);
+  }
+  if (releaseSeconds_ > 0)
+  {
+    interval = std::min(interval, releaseSeconds_);
+  }
+  timerId_ = loop_->runEvery(interval,
+                             makeWeakCallback(shared_from_this(),
+                                              &IdleConnectionList::onTimer));
+}
+
+void IdleConnectionList::stop()
+{
+  loop_->cancel(timerId_);
+}
+
+void IdleConnectionList::add(TcpConnection* conn, Timestamp now)
+{
+  loop_->assertInLoopThread();
+  assert(!linked(conn));
+  conn->lastReceiveTime_ = now;
+  link(conn);
+}
+
+void IdleConnectionList::touch(TcpConnection* conn, Timestamp receiveTime)
+{
+  loop_->assertInLoopThread();
+  conn->lastReceiveTime_ = receiveTime;
+  if (conn == releasedTail_)  //又活跃了，即使不用移动也要退出已释放的那一段
+  {
+    releasedTail_ = conn->idlePrev_;
+  }
+  if (linked(conn) && conn != tail_)  //已经被踢掉的连接不再加回来
+  {
+    unlink(conn);
+    link(conn);
+  }
+}
+
+void IdleConnectionList::remove(TcpConnection* conn)
+{
+  loop_->assertInLoopThread();
+  if (linked(conn))
+  {
+    unlink(conn);
+  }
+}
+
+void IdleConnectionList::onTimer()
+{
+  loop_->assertInLoopThread();
+  Timestamp now(Timestamp::now());
+  if (idleSeconds_ > 0)
+  {
+    closeIdle(now);
+  }
+  if (releaseSeconds_ > 0)
+  {
+    releaseIdle(now);
+  }
+}
+
+void IdleConnectionList::closeIdle(Timestamp now)
+{
+  while (head_ && timeDifference(now, head_->lastReceiveTime_) >= idleSeconds_)
+  {
+    TcpConnection* conn = head_;
+    unlink(conn);
+    LOG_INFO << "IdleConnectionList::onTimer - connection " << conn->name()
+             << " idle since " << conn->lastReceiveTime_.toFormattedString();
+    conn->forceClose();  //TcpServer仍持有它的shared_ptr，connectDestroyed()之前不会析构
+  }
+}
+
+void IdleConnectionList::releaseIdle(Timestamp now)
+{
+  TcpConnection* conn = releasedTail_ ? releasedTail_->idleNext_ : head_;
+  while (conn && timeDifference(now, conn->lastReceiveTime_) >= releaseSeconds_)
+  {
+    conn->releaseIdleBuffers();  //再收到数据时Buffer按需重新分配
+    releasedTail_ = conn;
+    conn = conn->idleNext_;
+  }
+}
+
+bool IdleConnectionList::linked(TcpConnection* conn) const
+{
+  return conn->idlePrev_ != NULL || head_ == conn;
+}
+
+void IdleConnectionList::link(TcpConnection* conn)
+{
+  conn->idlePrev_ = tail_;
+  conn->idleNext_ = NULL;
+  if (tail_)
+  {
+    tail_->idleNext_ = conn;
+  }
+  else
+  {
+    head_ = conn;
+  }
+  tail_ = conn;
+  ++size_;
+}
+
+void IdleConnectionList::unlink(TcpConnection* conn)
+{
+  if (conn == releasedTail_)
+  {
+    releasedTail_ = conn->idlePrev_;
+  }
+  if (conn->idlePrev_)
+  {
+    conn->idlePrev_->idleNext_ = conn->idleNext_;
+  }
+  else
+  {
+    head_ = conn->idleNext_;
+  }
+  if (conn->idleNext_)
+  {
+    conn->idleNext_->idlePrev_ = conn->idlePrev_;
+  }
+  else
+  {
+    tail_ = conn->idlePrev_;
+  }
+  conn->idlePrev_ = NULL;
+  conn->idleNext_ = NULL;
+  --size_;
+}
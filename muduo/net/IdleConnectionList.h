@@ -0,0 +1,76 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_IDLECONNECTIONLIST_H
+#define MUDUO_NET_IDLECONNECTIONLIST_H
+
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/TimerId.h>
+
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+class TcpConnection;
+
+///
+/// Closes connections of one loop which receive nothing for a while,
+/// and frees their buffers earlier.
+///
+/// 同一个loop中的连接按最后收到数据的时间串成侵入式双向链表，
+/// 收到数据时把连接移到链表尾，O(1)且不分配内存；
+/// 一个粗粒度的定时器从链表头开始踢掉空闲太久的连接。
+/// 见TcpServer::setIdleTimeout()，代替examples/idleconnection中的做法。
+/// 空闲超过releaseSeconds的连接释放Buffer的内存，链表头上已释放过的
+/// 一段由releasedTail_标记，定时器每次只看新变得空闲的连接。
+class IdleConnectionList : boost::noncopyable,
+                           public boost::enable_shared_from_this<IdleConnectionList>
+{
+ public:
+  /// Zero @c idleSeconds or @c releaseSeconds disables closing or freeing.
+  IdleConnectionList(EventLoop* loop, double idleSeconds, double releaseSeconds = 0.0);
+
+  void start();  //启动定时器，线程安全
+  void stop();  //取消定时器，线程安全
+
+  // 以下只能在loop线程中调用
+  void add(TcpConnection* conn, Timestamp now);
+  void touch(TcpConnection* conn, Timestamp receiveTime);  //收到数据，移到链表尾
+  void remove(TcpConnection* conn);
+
+  size_t size() const { return size_; }
+
+ private:
+  void onTimer();
+  void closeIdle(Timestamp now);
+  void releaseIdle(Timestamp now);
+  bool linked(TcpConnection* conn) const;
+  void link(TcpConnection* conn);
+  void unlink(TcpConnection* conn);
+
+  EventLoop* loop_;
+  const double idleSeconds_;
+  const double releaseSeconds_;
+  TimerId timerId_;
+  TcpConnection* head_;  //最久没有收到数据的连接
+  TcpConnection* tail_;
+  TcpConnection* releasedTail_;  //从head_到它的连接都已释放过Buffer，可能为NULL
+  size_t size_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_IDLECONNECTIONLIST_H
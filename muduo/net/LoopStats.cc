@@ -0,0 +1,302 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/LoopStats.h>
+
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/net/Channel.h>
+#include <muduo/net/EventLoop.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <assert.h>
+#include <execinfo.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+//所有活着的EventLoop的统计，Inspector从这里遍历
+MutexLock g_mutex;
+std::vector<LoopStats*> g_allStats;
+
+__thread LoopStats* t_statsInThisThread = NULL;  //信号处理函数据此找到本线程的loop
+}
+
+const int LoopStats::kMaxFrames;
+
+const int Histogram::kNumBuckets;
+
+//0~3各占一个桶，之后每个2的幂分成4个桶
+int Histogram::bucketOf(int64_t value)
+{
+  if (value < 4)
+  {
+    return value < 0 ? 0 : static_cast<int>(value);
+  }
+  int exp = 63 - __builtin_clzll(static_cast<unsigned long long>(value));
+  int sub = static_cast<int>(value >> (exp - 2)) & 3;
+  return std::min(4 + (exp - 2) * 4 + sub, kNumBuckets - 1);
+}
+
+int64_t Histogram::upperBoundOf(int bucket)
+{
+  if (bucket < 4)
+  {
+    return bucket;
+  }
+  int exp = (bucket - 4) / 4 + 2;
+  int sub = (bucket - 4) % 4;
+  int64_t width = static_cast<int64_t>(1) << (exp - 2);
+  return (4 + sub) * width + width - 1;
+}
+
+void Histogram::record(int64_t value)
+{
+  buckets_[bucketOf(value)].increment();
+  count_.increment();
+  sum_.add(value);
+  if (value > max_.get())
+  {
+    max_.set(value);
+  }
+}
+
+void Histogram::reset()
+{
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    buckets_[i].set(0);
+  }
+  count_.set(0);
+  sum_.set(0);
+  max_.set(0);
+}
+
+int64_t Histogram::percentile(double p) const
+{
+  int64_t counts[kNumBuckets];
+  int64_t total = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    counts[i] = buckets_[i].get();
+    total += counts[i];
+  }
+  if (total == 0)
+  {
+    return 0;
+  }
+  int64_t rank = static_cast<int64_t>(static_cast<double>(total) * p / 100.0 + 0.5);
+  rank = std::max(std::min(rank, total), static_cast<int64_t>(1));
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    seen += counts[i];
+    if (seen >= rank)
+    {
+      return std::min(upperBoundOf(i), max());
+    }
+  }
+  return max();
+}
+
+LoopStats::LoopStats(EventLoop* loop, const BufferPool* bufferPool)
+  : loop_(loop),
+    threadId_(CurrentThread::tid()),
+    threadName_(CurrentThread::name()),
+    pthreadId_(::pthread_self()),
+    bufferPool_(bufferPool),
+    maxCallbackName_(NULL),
+    nestedMicros_(0),
+    callbackStart_(0),
+    callbackKind_(kNone),
+    callbackChannel_(NULL),
+    callbackName_(NULL),
+    stackRequest_(0),
+    stackReady_(0),
+    reportedStart_(0)
+{
+  maxCallbackFd_.set(-1);
+  t_statsInThisThread = this;
+  MutexLockGuard lock(g_mutex);
+  g_allStats.push_back(this);
+}
+
+LoopStats::~LoopStats()
+{
+  MutexLockGuard lock(g_mutex);
+  std::vector<LoopStats*>::iterator it = std::find(g_allStats.begin(), g_allStats.end(), this);
+  assert(it != g_allStats.end());
+  g_allStats.erase(it);
+  t_statsInThisThread = NULL;
+}
+
+void LoopStats::forEach(const boost::function<void(LoopStats*)>& f)
+{
+  MutexLockGuard lock(g_mutex);
+  for (size_t i = 0; i < g_allStats.size(); ++i)
+  {
+    f(g_allStats[i]);
+  }
+}
+
+void LoopStats::recordPoll(int64_t micros)
+{
+  polls_.increment();
+  pollMicros_.add(micros);
+}
+
+//Channel回调里跑的定时器已经单独计过了，这里扣掉
+void LoopStats::recordChannel(int fd, int64_t micros)
+{
+  micros = std::max(micros - nestedMicros_, static_cast<int64_t>(0));
+  nestedMicros_ = 0;
+  channels_.record(micros);
+  updateMax(kChannel, fd, NULL, micros);
+}
+
+void LoopStats::recordDeferred(int64_t micros)
+{
+  deferredMicros_.add(micros);
+  updateMax(kDeferred, -1, NULL, micros);
+}
+
+void LoopStats::recordPendingFunctor(const char* name, int64_t micros)
+{
+  pendingFunctors_.record(micros);
+  updateMax(kPendingFunctor, -1, name, micros);
+}
+
+void LoopStats::recordPendingBatch(int64_t depth)
+{
+  pendingBatches_.record(depth);
+}
+
+void LoopStats::recordTimer(const char* name, int64_t micros)
+{
+  nestedMicros_ += micros;
+  timers_.record(micros);
+  updateMax(kTimer, -1, name, micros);
+}
+
+void LoopStats::updateMax(CallbackKind kind, int fd, const char* name, int64_t micros)
+{
+  if (micros > maxCallbackMicros_.get())
+  {
+    maxCallbackKind_.set(kind);
+    maxCallbackFd_.set(fd);
+    maxCallbackName_ = name;
+    maxCallbackMicros_.set(micros);
+  }
+}
+
+//Inspector线程调用，交给唯一的写者IO线程去清零
+void LoopStats::reset()
+{
+  if (loop_)
+  {
+    loop_->runInLoop(boost::bind(&LoopStats::resetInLoop, this));  //loop析构时未执行的任务直接丢弃
+  }
+  else
+  {
+    resetInLoop();
+  }
+}
+
+void LoopStats::resetInLoop()
+{
+  polls_.set(0);
+  pollMicros_.set(0);
+  deferredMicros_.set(0);
+  channels_.reset();
+  pendingFunctors_.reset();
+  pendingBatches_.reset();
+  timers_.reset();
+  maxCallbackMicros_.set(0);
+  maxCallbackKind_.set(kNone);
+  maxCallbackFd_.set(-1);
+  maxCallbackName_ = NULL;
+}
+
+void LoopStats::requestStack(int64_t startMicros)
+{
+  stackReady_ = 0;
+  __sync_synchronize();
+  stackRequest_ = startMicros;
+}
+
+const LoopStats::StackSample* LoopStats::stackSample() const
+{
+  if (stackRequest_ == 0 || stackReady_ != stackRequest_)
+  {
+    return NULL;
+  }
+  __sync_synchronize();
+  return &stack_;
+}
+
+bool LoopStats::copyStackSample(const LoopStats* stats, StackSample* sample)
+{
+  MutexLockGuard lock(g_mutex);
+  if (std::find(g_allStats.begin(), g_allStats.end(), stats) == g_allStats.end())
+  {
+    return false;  //loop已经析构了
+  }
+  const StackSample* ready = stats->stackSample();
+  if (ready)
+  {
+    *sample = *ready;
+  }
+  return ready != NULL;
+}
+
+//在信号处理函数中执行，只能做简单的内存读写；
+//被打断的正是那个回调，所以它的Channel还活着
+void LoopStats::captureStack()
+{
+  LoopStats* stats = t_statsInThisThread;
+  if (stats == NULL || stats->stackRequest_ == 0)
+  {
+    return;
+  }
+  StackSample& sample = stats->stack_;
+  int64_t start = stats->callbackStart_;
+  sample.callbackStart = start;
+  sample.kind = kNone;
+  sample.fd = -1;
+  sample.name = NULL;
+  sample.ownerName[0] = '\0';
+  sample.ownerId = 0;
+  sample.numFrames = 0;
+  if (start == stats->stackRequest_)
+  {
+    sample.kind = stats->callbackKind_;
+    sample.name = stats->callbackName_;
+    Channel* channel = stats->callbackChannel_;
+    if (channel)
+    {
+      sample.fd = channel->fd();
+      const char* owner = channel->ownerName();
+      size_t i = 0;
+      for (; owner && owner[i] && i < sizeof sample.ownerName - 1; ++i)
+      {
+        sample.ownerName[i] = owner[i];
+      }
+      sample.ownerName[i] = '\0';
+      sample.ownerId = channel->ownerId();
+    }
+    sample.numFrames = ::backtrace(sample.frames, kMaxFrames);
+  }
+  __sync_synchronize();
+  stats->stackReady_ = stats->stackRequest_;
+}
@@ -0,0 +1,202 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_LOOPSTATS_H
+#define MUDUO_NET_LOOPSTATS_H
+
+#include <muduo/base/Types.h>
+#include <muduo/net/StatCounter.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <pthread.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class BufferPool;
+class Channel;
+class EventLoop;
+
+///
+/// Log-linear histogram, like HdrHistogram with two significant bits:
+/// each power of two is split into four buckets, percentiles are within 25%.
+/// Lock-free, one writer and any number of readers.
+///
+class Histogram : boost::noncopyable
+{
+ public:
+  static const int kNumBuckets = 160;
+
+  // 以下只在写者线程中调用
+  void record(int64_t value);
+  void reset();
+
+  int64_t count() const { return count_.get(); }
+  int64_t sum() const { return sum_.get(); }
+  int64_t max() const { return max_.get(); }
+  /// Upper bound of the bucket the @c p percentile falls in, 0 < p <= 100.
+  int64_t percentile(double p) const;
+
+  static int bucketOf(int64_t value);
+  static int64_t upperBoundOf(int bucket);
+
+ private:
+  StatCounter buckets_[kNumBuckets];
+  StatCounter count_;
+  StatCounter sum_;
+  StatCounter max_;
+};
+
+///
+/// Latency and utilization counters of one EventLoop, in microseconds.
+/// Written by the loop thread only, readable from any thread,
+/// see /loops/stats of Inspector.
+///
+class LoopStats : boost::noncopyable
+{
+ public:
+  enum CallbackKind
+  {
+    kNone,
+    kChannel,  //Channel::handleEvent()
+    kDeferred,  //EventLoop::queueDeferred()的任务
+    kPendingFunctor,  //EventLoop::queueInLoop()的任务
+    kTimer,  //定时器回调
+  };
+
+  //在IO线程中构造，登记到全局列表；loop为NULL时reset()直接在调用线程中清零
+  explicit LoopStats(EventLoop* loop = NULL, const BufferPool* bufferPool = NULL);
+  ~LoopStats();
+
+  // 以下只在IO线程中调用
+  void recordPoll(int64_t micros);
+  void recordChannel(int fd, int64_t micros);  //包括其中定时器回调之外的时间
+  void recordDeferred(int64_t micros);
+  void recordPendingFunctor(const char* name, int64_t micros);
+  void recordPendingBatch(int64_t depth);  //一次取走的任务数
+  void recordTimer(const char* name, int64_t micros);
+
+  // 以下可在任意线程调用
+  pid_t threadId() const { return threadId_; }
+  const string& threadName() const { return threadName_; }
+  const BufferPool* bufferPool() const { return bufferPool_; }  //见/loops/buffers，可能为NULL
+
+  int64_t polls() const { return polls_.get(); }
+  int64_t pollMicroSeconds() const { return pollMicros_.get(); }
+  int64_t deferredMicroSeconds() const { return deferredMicros_.get(); }
+  const Histogram& channels() const { return channels_; }
+  const Histogram& pendingFunctors() const { return pendingFunctors_; }
+  const Histogram& pendingBatches() const { return pendingBatches_; }
+  const Histogram& timers() const { return timers_; }
+
+  /// The slowest single callback so far, fields may come from different callbacks
+  /// if it changes while being read.
+  int64_t maxCallbackMicroSeconds() const { return maxCallbackMicros_.get(); }
+  CallbackKind maxCallbackKind() const { return static_cast<CallbackKind>(maxCallbackKind_.get()); }
+  int maxCallbackFd() const { return static_cast<int>(maxCallbackFd_.get()); }
+  const char* maxCallbackName() const { return maxCallbackName_; }  //mangled类型名，可能为NULL
+
+  /// Thread safe, the counters are cleared in the loop thread,
+  /// their only writer, so it may take effect a bit later.
+  void reset();
+
+  // 以下供LoopWatchdog使用
+
+  // 只在IO线程中调用，标记正在执行的回调
+  void enterCallback(CallbackKind kind, Channel* channel, const char* name, int64_t startMicros)
+  {
+    callbackKind_ = kind;
+    callbackChannel_ = channel;
+    callbackName_ = name;
+    callbackStart_ = startMicros;  //最后写，看到它时前面几个字段已经是这个回调的
+  }
+  void leaveCallback() { callbackStart_ = 0; }
+
+  /// When the current callback started, 0 if not in any callback.
+  int64_t callbackStartMicroSeconds() const { return callbackStart_; }
+  pthread_t pthreadId() const { return pthreadId_; }
+
+  static const int kMaxFrames = 64;
+  struct StackSample
+  {
+    int64_t callbackStart;  //与请求的不同说明那个回调已经返回了
+    CallbackKind kind;
+    int fd;
+    const char* name;
+    char ownerName[64];
+    int64_t ownerId;
+    void* frames[kMaxFrames];
+    int numFrames;
+  };
+
+  /// Asks for a stack of the callback started at @c startMicros,
+  /// then signal the loop thread to run captureStack().
+  void requestStack(int64_t startMicros);
+  /// The sample, or NULL if the loop thread has not answered yet.
+  const StackSample* stackSample() const;
+  /// Copies the sample of @c stats if that loop is still alive and has answered.
+  /// Thread safe, @c stats may be a dangling pointer.
+  static bool copyStackSample(const LoopStats* stats, StackSample* sample);
+  /// Async-signal-safe, run in the loop thread by the signal handler.
+  static void captureStack();
+
+  int64_t reportedCallbackStart() const { return reportedStart_; }
+  void setReportedCallbackStart(int64_t start) { reportedStart_ = start; }
+
+  /// Calls f with the stats of every live EventLoop, under a lock
+  /// which also keeps loops from destructing meanwhile.
+  static void forEach(const boost::function<void(LoopStats*)>& f);
+
+ private:
+  void updateMax(CallbackKind kind, int fd, const char* name, int64_t micros);
+  void resetInLoop();
+
+  EventLoop* const loop_;
+  const pid_t threadId_;
+  const string threadName_;
+  const pthread_t pthreadId_;
+  const BufferPool* const bufferPool_;
+
+  StatCounter polls_;
+  StatCounter pollMicros_;
+  StatCounter deferredMicros_;
+  Histogram channels_;
+  Histogram pendingFunctors_;
+  Histogram pendingBatches_;
+  Histogram timers_;
+
+  StatCounter maxCallbackMicros_;
+  StatCounter maxCallbackKind_;
+  StatCounter maxCallbackFd_;
+  const char* volatile maxCallbackName_;  //指向type_info中的静态字符串
+
+  int64_t nestedMicros_;  //当前Channel回调中已计入定时器的时间，只在IO线程中访问
+
+  // 正在执行的回调，IO线程写，LoopWatchdog线程读，64位对齐的读写在x86-64上是原子的
+  volatile int64_t callbackStart_;
+  volatile CallbackKind callbackKind_;
+  Channel* volatile callbackChannel_;
+  const char* volatile callbackName_;
+
+  // LoopWatchdog请求、信号处理函数应答
+  volatile int64_t stackRequest_;
+  volatile int64_t stackReady_;
+  StackSample stack_;
+  int64_t reportedStart_;  //已经报告过的回调，只在LoopWatchdog线程中访问
+};
+
+}
+}
+
+#endif  // MUDUO_NET_LOOPSTATS_H
@@ -0,0 +1,239 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/LoopWatchdog.h>
+
+#include <muduo/base/Exception.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/LoopStats.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+#include <cxxabi.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const int kStackSignal = SIGURG;
+const int kMaxWaitForStackMs = 100;  //信号处理函数迟迟不应答，线程可能阻塞了信号
+
+void onStackSignal(int)
+{
+  int savedErrno = errno;
+  LoopStats::captureStack();
+  errno = savedErrno;
+}
+
+string demangle(const char* name)
+{
+  if (name == NULL)
+  {
+    return "";
+  }
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+  string result(status == 0 && demangled ? demangled : name);
+  free(demangled);
+  return result;
+}
+
+string describe(const LoopStats::StackSample& sample)
+{
+  char buf[128];
+  switch (sample.kind)
+  {
+    case LoopStats::kChannel:
+      if (sample.ownerId > 0)
+      {
+        snprintf(buf, sizeof buf, "channel fd %d [%s%lld]", sample.fd, sample.ownerName,
+                 static_cast<long long>(sample.ownerId));
+      }
+      else
+      {
+        snprintf(buf, sizeof buf, "channel fd %d [%s]", sample.fd, sample.ownerName);
+      }
+      return buf;
+    case LoopStats::kDeferred:
+      return "deferred functors";
+    case LoopStats::kPendingFunctor:
+      return "pending functor " + demangle(sample.name);
+    default:
+      return "unknown callback";
+  }
+}
+
+}
+
+struct LoopWatchdog::SlowLoop
+{
+  const LoopStats* stats;  //释放全局锁后可能已经析构，只用来找回调用栈
+  pid_t threadId;
+  string threadName;
+  int64_t callbackStart;
+  bool signaled;
+};
+
+LoopWatchdog::LoopWatchdog(double thresholdSeconds)
+  : thresholdMicroSeconds_(static_cast<int64_t>(thresholdSeconds * Timestamp::kMicroSecondsPerSecond)),
+    captureStack_(true),
+    running_(false),
+    mutex_(),
+    cond_(mutex_),
+    thread_(boost::bind(&LoopWatchdog::threadFunc, this), "LoopWatchdog")
+{
+  assert(thresholdMicroSeconds_ > 0);
+}
+
+LoopWatchdog::~LoopWatchdog()
+{
+  stop();
+}
+
+void LoopWatchdog::start()
+{
+  assert(!thread_.started());
+  // backtrace()第一次调用时会加载libgcc并分配内存，先在这里调一次，之后在信号处理函数中才安全
+  void* frame = NULL;
+  ::backtrace(&frame, 1);
+
+  struct sigaction old;
+  if (captureStack_ && ::sigaction(kStackSignal, NULL, &old) == 0
+      && old.sa_handler != SIG_DFL && old.sa_handler != SIG_IGN
+      && old.sa_handler != onStackSignal)
+  {
+    LOG_WARN << "LoopWatchdog::start - SIGURG is in use, reports come without stacks";
+    captureStack_ = false;  //不抢程序自己的信号处理函数
+  }
+  if (captureStack_)
+  {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = onStackSignal;
+    sa.sa_flags = SA_RESTART;  //被打断的回调里的系统调用自动重启
+    ::sigemptyset(&sa.sa_mask);
+    if (::sigaction(kStackSignal, &sa, NULL) < 0)
+    {
+      LOG_SYSERR << "LoopWatchdog::start - sigaction";
+      captureStack_ = false;
+    }
+  }
+
+  running_ = true;
+  thread_.start();
+}
+
+void LoopWatchdog::stop()
+{
+  {
+    MutexLockGuard lock(mutex_);
+    if (!running_)
+    {
+      return;
+    }
+    running_ = false;
+    cond_.notify();
+  }
+  thread_.join();
+}
+
+void LoopWatchdog::threadFunc()
+{
+  //检查间隔取阈值的一半，卡住的回调最多晚半个阈值被发现
+  double interval = static_cast<double>(thresholdMicroSeconds_) / 2 / Timestamp::kMicroSecondsPerSecond;
+  while (true)
+  {
+    {
+      MutexLockGuard lock(mutex_);
+      if (running_)
+      {
+        cond_.waitForSeconds(interval);
+      }
+      if (!running_)
+      {
+        break;
+      }
+    }
+    checkAll();  //不持有mutex_，stop()不用等它
+  }
+}
+
+void LoopWatchdog::checkAll()
+{
+  std::vector<SlowLoop> slowLoops;
+  LoopStats::forEach(boost::bind(&LoopWatchdog::collect, this, _1,
+                                 Timestamp::now().microSecondsSinceEpoch(), &slowLoops));
+  //等调用栈要好几毫秒，这时不能持有全局锁，否则loop析构和Inspector都得等
+  for (size_t i = 0; i < slowLoops.size(); ++i)
+  {
+    report(slowLoops[i]);
+  }
+}
+
+void LoopWatchdog::collect(LoopStats* stats, int64_t now, std::vector<SlowLoop>* slowLoops)
+{
+  int64_t start = stats->callbackStartMicroSeconds();
+  if (start == 0 || now - start < thresholdMicroSeconds_
+      || start == stats->reportedCallbackStart())
+  {
+    return;
+  }
+  stats->setReportedCallbackStart(start);
+  numReports_.increment();
+
+  SlowLoop slow = { stats, stats->threadId(), stats->threadName(), start, false };
+  if (captureStack_)
+  {
+    //持有全局锁，loop线程还没有退出，pthread_kill()是安全的
+    stats->requestStack(start);
+    slow.signaled = ::pthread_kill(stats->pthreadId(), kStackSignal) == 0;
+  }
+  slowLoops->push_back(slow);
+}
+
+void LoopWatchdog::report(const SlowLoop& slow)
+{
+  LoopStats::StackSample sample;
+  bool sampled = false;
+  for (int i = 0; slow.signaled && i < kMaxWaitForStackMs
+       && !(sampled = LoopStats::copyStackSample(slow.stats, &sample)); ++i)
+  {
+    ::usleep(1000);
+  }
+
+  int64_t elapsedMs = (Timestamp::now().microSecondsSinceEpoch() - slow.callbackStart) / 1000;
+  if (!sampled)
+  {
+    LOG_WARN << "LoopWatchdog - loop " << slow.threadName << " tid " << slow.threadId
+             << " in one callback for " << elapsedMs << " ms, no stack";
+  }
+  else if (sample.callbackStart != slow.callbackStart)
+  {
+    LOG_WARN << "LoopWatchdog - loop " << slow.threadName << " tid " << slow.threadId
+             << " was in one callback for over " << thresholdMicroSeconds_ / 1000 << " ms"
+             << ", it returned before the stack was taken";
+  }
+  else
+  {
+    LOG_WARN << "LoopWatchdog - loop " << slow.threadName << " tid " << slow.threadId
+             << " in " << describe(sample) << " for " << elapsedMs << " ms, stack:\n"
+             << Exception::symbolize(sample.frames, sample.numFrames);
+  }
+}
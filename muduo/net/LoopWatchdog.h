@@ -0,0 +1,79 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOOPWATCHDOG_H
+#define MUDUO_NET_LOOPWATCHDOG_H
+
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Condition.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/Thread.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class LoopStats;
+
+///
+/// Optional watchdog thread for all EventLoops of the process.
+///
+/// When a loop thread stays in one callback longer than @c thresholdSeconds,
+/// it logs the stack of that thread, with the channel's fd and the connection name.
+/// The stack is captured in a SIGURG handler installed by start(),
+/// SIGURG is ignored by default so it is harmless to other threads.
+/// If the program has its own SIGURG handler, or setCaptureStack(false)
+/// was called, the watchdog leaves SIGURG alone and reports without stacks.
+/// Each slow callback is reported once.
+///
+/// 每个loop在执行回调前后打标记(见LoopStats)，watchdog定期检查，
+/// 卡住太久就给那个线程发信号，在信号处理函数中取调用栈
+class LoopWatchdog : boost::noncopyable
+{
+ public:
+  explicit LoopWatchdog(double thresholdSeconds = 0.5);
+  ~LoopWatchdog();  //会调用stop()
+
+  /// Signals slow loop threads for their stacks, true by default.
+  /// Must be called before @c start
+  void setCaptureStack(bool on) { captureStack_ = on; }
+
+  void start();
+  void stop();
+
+  /// Number of slow callbacks reported.
+  int64_t numReports() const { return numReports_.get(); }
+
+ private:
+  struct SlowLoop;
+  void threadFunc();
+  void checkAll();
+  //在LoopStats::forEach()中调用，持有全局锁，只记下卡住的loop并发信号
+  void collect(LoopStats* stats, int64_t now, std::vector<SlowLoop>* slowLoops);
+  void report(const SlowLoop& slow);  //不持锁等待调用栈
+
+  const int64_t thresholdMicroSeconds_;
+  bool captureStack_;  //start()之后就是是否装上了信号处理函数
+  bool running_;
+  MutexLock mutex_;
+  Condition cond_;
+  Thread thread_;
+  mutable AtomicInt64 numReports_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_LOOPWATCHDOG_H
@@ -10,6 +10,8 @@
 
 #include <muduo/net/Channel.h>
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -25,7 +27,55 @@ Poller::~Poller()
 bool Poller::hasChannel(Channel* channel) const
 {
   assertInLoopThread();
-  ChannelMap::const_iterator it = channels_.find(channel->fd());
-  return it != channels_.end() && it->second == channel;
+  return channels_.find(channel->fd()) == channel;
+}
+
+const int Poller::kMaxFdTableSize;
+
+void Poller::ChannelMap::add(int fd, Channel* channel)
+{
+  assert(fd >= 0 && channel != NULL);
+  if (fd < kMaxFdTableSize)
+  {
+    if (implicit_cast<size_t>(fd) >= table_.size())
+    {
+      //至少翻倍，fd逐个增长时摊还O(1)
+      size_t newSize = std::max(implicit_cast<size_t>(fd) + 1, table_.size() * 2);
+      table_.resize(std::min(newSize, implicit_cast<size_t>(kMaxFdTableSize)), NULL);
+    }
+    assert(table_[fd] == NULL);
+    table_[fd] = channel;
+  }
+  else
+  {
+    bool inserted = map_.insert(std::make_pair(fd, channel)).second;
+    assert(inserted); (void)inserted;
+  }
+  ++size_;
+}
+
+size_t Poller::ChannelMap::erase(int fd)
+{
+  size_t n = 0;
+  if (fd < kMaxFdTableSize)
+  {
+    if (implicit_cast<size_t>(fd) < table_.size() && table_[fd] != NULL)
+    {
+      table_[fd] = NULL;
+      n = 1;
+    }
+  }
+  else
+  {
+    n = map_.erase(fd);
+  }
+  size_ -= n;
+  return n;
+}
+
+Channel* Poller::ChannelMap::findInMap(int fd) const
+{
+  std::map<int, Channel*>::const_iterator it = map_.find(fd);
+  return it != map_.end() ? it->second : NULL;
 }
 
@@ -52,6 +52,9 @@ class Poller : boost::noncopyable
 
   virtual bool hasChannel(Channel* channel) const;
 
+  /// Whether Channel::setEdgeTriggered() takes effect.
+  virtual bool supportsEdgeTriggered() const { return false; }
+
   static Poller* newDefaultPoller(EventLoop* loop);
 
   void assertInLoopThread() const
@@ -60,7 +63,39 @@ class Poller : boost::noncopyable
   }
 
  protected:
-  typedef std::map<int, Channel*> ChannelMap;
+  //以fd为下标的表最多这么大，更大的fd放进map，免得一个大fd撑大整个vector
+  static const int kMaxFdTableSize = 1024 * 1024;
+
+  ///
+  /// fd -> Channel*, looked up on every updateChannel()/removeChannel().
+  ///
+  /// fd是从小往上分配的整数，直接用fd做下标查vector，按需增长，
+  /// 比std::map少了每次查找的指针跳转；特别大的fd才放进map里。
+  class ChannelMap : boost::noncopyable
+  {
+   public:
+    ChannelMap() : size_(0) {}
+
+    Channel* find(int fd) const  //找不到返回NULL
+    {
+      if (implicit_cast<size_t>(fd) < table_.size())
+      {
+        return table_[fd];
+      }
+      return fd < kMaxFdTableSize ? NULL : findInMap(fd);
+    }
+    void add(int fd, Channel* channel);
+    size_t erase(int fd);
+    size_t size() const { return size_; }
+
+   private:
+    Channel* findInMap(int fd) const;
+
+    std::vector<Channel*> table_;  //下标为fd
+    std::map<int, Channel*> map_;  //fd >= kMaxFdTableSize
+    size_t size_;
+  };
+
   ChannelMap channels_;
 
  private:
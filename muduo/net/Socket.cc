@@ -93,6 +93,25 @@ void Socket:: setTcpNoDelay(bool on)
   // FIXME CHECK
 }
 
+bool Socket::setBusyPoll(int usec)
+{
+#ifdef SO_BUSY_POLL
+  int optval = usec;
+  int ret = ::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL,
+                         &optval, static_cast<socklen_t>(sizeof optval));
+  if (ret < 0)
+  {
+    LOG_SYSERR << "SO_BUSY_POLL failed.";
+    return false;
+  }
+  return true;
+#else
+  (void)usec;
+  LOG_ERROR << "SO_BUSY_POLL is not supported.";
+  return false;
+#endif
+}
+
 void Socket::setReuseAddr(bool on)
 {
   int optval = on ? 1 : 0;
@@ -84,6 +84,12 @@ class Socket : boost::noncopyable
   /// TCP keepalive是指定期探测连接是否存在，如果应用层有心跳的话，这个选项不是必需要设置的
   void setKeepAlive(bool on);
 
+  ///
+  /// Sets SO_BUSY_POLL, microseconds to busy poll the device queue on blocking reads.
+  ///
+  /// 需要CAP_NET_ADMIN才能调大，失败时只记日志，返回是否成功
+  bool setBusyPoll(int usec);
+
  private:
   const int sockfd_; //socket文件描述符
 };
@@ -16,7 +16,9 @@
 #include <fcntl.h>
 #include <stdio.h>  // snprintf
 #include <strings.h>  // bzero
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/uio.h>  // readv
 #include <unistd.h>
 
 using namespace muduo;
@@ -127,7 +129,10 @@ int sockets::accept(int sockfd, struct sockaddr_in6* addr)
   if (connfd < 0)
   {
     int savedErrno = errno;
-    LOG_SYSERR << "Socket::accept";
+    if (savedErrno != EAGAIN)  //Acceptor循环accept直到EAGAIN，这不算错误
+    {
+      LOG_SYSERR << "Socket::accept";
+    }
     switch (savedErrno)
     {
       case EAGAIN:
@@ -179,6 +184,18 @@ ssize_t sockets::write(int sockfd, const void *buf, size_t count)
   return ::write(sockfd, buf, count);
 }
 
+//writev把多个缓冲区的数据一次写出，见BufferChain::writeFd
+ssize_t sockets::writev(int sockfd, const struct iovec *iov, int iovcnt)
+{
+  return ::writev(sockfd, iov, iovcnt);
+}
+
+//在内核中把文件fd的数据直接发到sockfd，不经过用户态缓冲
+ssize_t sockets::sendfile(int sockfd, int fd, off_t *offset, size_t count)
+{
+  return ::sendfile(sockfd, fd, offset, count);
+}
+
 void sockets::close(int sockfd)
 {
   if (::close(sockfd) < 0)
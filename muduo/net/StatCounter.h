@@ -0,0 +1,43 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_STATCOUNTER_H
+#define MUDUO_NET_STATCOUNTER_H
+
+#include <muduo/base/Types.h>
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// Counter written by one thread, which uses a relaxed load and store
+/// instead of a locked read-modify-write.  Any thread may read it.
+///
+class StatCounter
+{
+ public:
+  StatCounter() : value_(0) {}
+
+  int64_t get() const { return __atomic_load_n(&value_, __ATOMIC_RELAXED); }
+  void set(int64_t x) { __atomic_store_n(&value_, x, __ATOMIC_RELAXED); }
+  void add(int64_t x) { set(get() + x); }  //只有一个写者，不会丢失更新
+  void increment() { add(1); }
+  void decrement() { add(-1); }
+
+ private:
+  int64_t value_;
+};
+
+}
+}
+
+#endif  // MUDUO_NET_STATCOUNTER_H
@@ -63,6 +63,7 @@ TcpClient::TcpClient(EventLoop* loop,
     messageCallback_(defaultMessageCallback),
     retry_(false),
     connect_(true),
+    edgeTriggered_(false),
     nextConnId_(1)
 {
   connector_->setNewConnectionCallback(
@@ -148,18 +149,20 @@ void TcpClient::newConnection(int sockfd)
   InetAddress localAddr(sockets::getLocalAddr(sockfd)); //获取本地地址
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(loop_,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));   // 创建一个TcpConnection对象
+  TcpConnectionPtr conn(TcpConnection::create(loop_,
+                                               connName,
+                                               sockfd,
+                                               localAddr,
+                                               peerAddr));   // 创建一个TcpConnection对象
 
   //设置建立连接,接收消息,写完成,关闭连接回调函数
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
+  conn->setHandleMessageCallback(handleMessageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
       boost::bind(&TcpClient::removeConnection, this, _1)); // FIXME: unsafe
+  conn->setEdgeTriggered(edgeTriggered_);
   {
     MutexLockGuard lock(mutex_);
     connection_ = conn;
@@ -54,6 +54,10 @@ class TcpClient : boost::noncopyable
   bool retry() const { return retry_; }   // 重连
   void enableRetry() { retry_ = true; }   // 允许重连  
 
+  /// Registers connections with EPOLLET, see TcpServer::setEdgeTriggered().
+  /// Takes effect from the next connection.
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
   const string& name() const   // 获取名字
   { return name_; }
 
@@ -67,6 +71,11 @@ class TcpClient : boost::noncopyable
   void setMessageCallback(const MessageCallback& cb)
   { messageCallback_ = cb; }
 
+  /// Set message callback taking TcpConnectionHandle, replaces MessageCallback.
+  /// Not thread safe.
+  void setHandleMessageCallback(const HandleMessageCallback& cb)
+  { handleMessageCallback_ = cb; }
+
   /// Set write complete callback.
   /// Not thread safe.
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
@@ -92,9 +101,11 @@ class TcpClient : boost::noncopyable
   const string name_;
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
+  HandleMessageCallback handleMessageCallback_;
   WriteCompleteCallback writeCompleteCallback_;
   bool retry_;   // atomic   //是否重连，是指建立的连接成功后又断开是否重连。而Connector的重连是一直不成功是否重试的意思
   bool connect_; // atomic   // 是否已经建立连接
+  bool edgeTriggered_;
   // always in loop thread
   int nextConnId_;          //代表第几个连接,name_+nextConnid_用于标识一个连接
   mutable MutexLock mutex_;
@@ -10,18 +10,30 @@
 
 #include <muduo/base/Logging.h>
 #include <muduo/base/WeakCallback.h>
+#include <muduo/net/BufferChain.h>
 #include <muduo/net/Channel.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/IdleConnectionList.h>
 #include <muduo/net/Socket.h>
 #include <muduo/net/SocketsOps.h>
 
 #include <boost/bind.hpp>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+//没有CAP_NET_ADMIN时SO_BUSY_POLL每次都会失败，一个IO线程失败过一次就不再尝试
+__thread bool t_busyPollFailed = false;
+}
+
 void muduo::net::defaultConnectionCallback(const TcpConnectionPtr& conn)
 {
   LOG_TRACE << conn->localAddress().toIpPort() << " -> "
@@ -37,21 +49,71 @@ void muduo::net::defaultMessageCallback(const TcpConnectionPtr&,
   buf->retrieveAll();
 }
 
+TcpConnectionPtr TcpConnection::create(EventLoop* loop,
+                                       const string& name,
+                                       int sockfd,
+                                       const InetAddress& localAddr,
+                                       const InetAddress& peerAddr)
+{
+  return TcpConnectionPtr(new TcpConnection(loop, boost::shared_ptr<const string>(), 0,
+                                            name, sockfd, localAddr, peerAddr),
+                          &TcpConnection::release);  //TcpConnectionHandle可能比它活得久
+}
+
+//TcpServer用：接受连接时不拼名字，用到时才生成
+TcpConnectionPtr TcpConnection::create(EventLoop* loop,
+                                       const boost::shared_ptr<const string>& namePrefix,
+                                       int64_t id,
+                                       int sockfd,
+                                       const InetAddress& localAddr,
+                                       const InetAddress& peerAddr)
+{
+  assert(namePrefix);
+  return TcpConnectionPtr(new TcpConnection(loop, namePrefix, id, string(), sockfd, localAddr, peerAddr),
+                          &TcpConnection::release);
+}
+
 TcpConnection::TcpConnection(EventLoop* loop,  // 建立连接需要一个Reactor
+                             const boost::shared_ptr<const string>& namePrefix,  // 为空时用nameArg
+                             int64_t id,
                              const string& nameArg,  // 连接名称
                              int sockfd,            // 已经由Acceptor建立好连接的sockfd
                              const InetAddress& localAddr,  // 本地地址
                              const InetAddress& peerAddr)  // 对端地址
   : loop_(CHECK_NOTNULL(loop)),
+    namePrefix_(namePrefix),
+    id_(id),
     name_(nameArg),
+    nameState_(namePrefix ? kNameEmpty : kNameReady),
     state_(kConnecting),    //因为sockfd是已经建立好连接的sockfd，所以设置kConnecting
     reading_(true),
+    edgeTriggered_(false),
+    readBudgetBytes_(kDefaultReadBudgetBytes),
+    readBudgetMessages_(kDefaultReadBudgetMessages),
+    budgetIteration_(-1),
+    bytesThisIteration_(0),
+    messagesThisIteration_(0),
     socket_(new Socket(sockfd)), //RAII管理套接字
     channel_(new Channel(loop, sockfd)),  //channel与sockfd绑定
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)  //高水位,64M
+    highWaterMark_(64*1024*1024),  //高水位,64M
+    inputBuffer_(loop->bufferPool(), 0),  //在IO线程中第一次写入时才分配
+    outputBuffer_(loop->bufferPool(), 0),
+    idlePrev_(NULL),
+    idleNext_(NULL),
+    sharedReadBuffer_(false),
+    loopRefs_(0),
+    holdsLoopRef_(false)
 {
+  if (namePrefix_)
+  {
+    channel_->setOwnerName(namePrefix_->c_str(), id_);
+  }
+  else
+  {
+    channel_->setOwnerName(name_.c_str());
+  }
     //设置channel各种回调
   channel_->setReadCallback(          
       boost::bind(&TcpConnection::handleRead, this, _1));
@@ -61,17 +123,90 @@ TcpConnection::TcpConnection(EventLoop* loop,  // 建立连接需要一个Reacto
       boost::bind(&TcpConnection::handleClose, this));
   channel_->setErrorCallback(
       boost::bind(&TcpConnection::handleError, this));
-  LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::ctor[" <<  name() << "] at " << this
             << " fd=" << sockfd;
   socket_->setKeepAlive(true);
+  refs_.getAndSet(1);  //代表全部TcpConnectionPtr，由release()释放
+  loop_->connectionCreated();  //构造时就计入，同一批新连接选loop时能看到彼此
+}
+
+//抢到生成权的线程拼名字，其他线程等它拼完
+const string& TcpConnection::formatName() const
+{
+  if (__sync_bool_compare_and_swap(&nameState_, kNameEmpty, kNameFormatting))
+  {
+    char buf[32];
+    snprintf(buf, sizeof buf, "%lld", static_cast<long long>(id_));
+    name_.reserve(namePrefix_->size() + strlen(buf));
+    name_ = *namePrefix_;
+    name_ += buf;
+    __sync_synchronize();
+    nameState_ = kNameReady;
+  }
+  else
+  {
+    while (nameState_ != kNameReady)
+    {
+      sched_yield();
+    }
+  }
+  return name_;
 }
 
 TcpConnection::~TcpConnection()
 {
-  LOG_DEBUG << "TcpConnection::dtor[" <<  name_ << "] at " << this
+  LOG_DEBUG << "TcpConnection::dtor[" <<  name() << "] at " << this
             << " fd=" << channel_->fd()
             << " state=" << stateToString();
   assert(state_ == kDisconnected);
+  assert(loopRefs_ == 0);
+}
+
+void TcpConnection::release(TcpConnection* conn)
+{
+  conn->releaseShared();
+}
+
+bool TcpConnection::addRef()
+{
+  if (loop_->isInLoopThread())
+  {
+    if (loopRefs_++ == 0)
+    {
+      refs_.increment();
+    }
+    return true;
+  }
+  refs_.increment();
+  return false;
+}
+
+void TcpConnection::releaseRef(bool loopRef)
+{
+  if (!loopRef)
+  {
+    releaseShared();
+  }
+  else if (loop_->isInLoopThread())
+  {
+    if (--loopRefs_ == 0)
+    {
+      releaseShared();
+    }
+  }
+  else
+  {
+    //loopRefs_只能在loop线程中修改，这个引用保证了this在此之前不会析构
+    loop_->queueInLoop(boost::bind(&TcpConnection::releaseRef, this, true));
+  }
+}
+
+void TcpConnection::releaseShared()
+{
+  if (refs_.decrementAndGet() == 0)
+  {
+    delete this;
+  }
 }
 
 bool TcpConnection::getTcpInfo(struct tcp_info* tcpi) const
@@ -133,13 +268,131 @@ void TcpConnection::send(Buffer* buf)
   }
 }
 
+//message只增加引用计数，跨线程时也不拷贝
+void TcpConnection::send(const SharedStringPtr& message)
+{
+  if (state_ == kConnected)
+  {
+    if (loop_->isInLoopThread())
+    {
+      sendSharedInLoop(message);
+    }
+    else
+    {
+      loop_->runInLoop(
+          boost::bind(&TcpConnection::sendSharedInLoop,
+                      this,     // FIXME
+                      message));
+    }
+  }
+}
+
+void TcpConnection::sendSharedInLoop(const SharedStringPtr& message)
+{
+  sendInLoop(message->data(), message->size(), message);
+}
+
+class TcpConnection::DupFile : boost::noncopyable
+{
+ public:
+  explicit DupFile(int fd)
+    : fd_(fd)
+  {
+  }
+
+  ~DupFile()
+  {
+    if (fd_ >= 0)
+    {
+      ::close(fd_);
+    }
+  }
+
+  int release()  //交给outputChain_
+  {
+    int fd = fd_;
+    fd_ = -1;
+    return fd;
+  }
+
+ private:
+  int fd_;
+};
+
+//fd先dup一份，由outputChain_负责关闭，调用者可以立刻关闭自己的fd
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+  if (state_ == kConnected)
+  {
+    int dupfd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (dupfd < 0)
+    {
+      LOG_SYSERR << "TcpConnection::sendFile";
+      return;
+    }
+    boost::shared_ptr<DupFile> file(new DupFile(dupfd));
+    loop_->runInLoop(
+        boost::bind(&TcpConnection::sendFileInLoop,
+                    this,     // FIXME
+                    file, offset, length));
+  }
+}
+
+void TcpConnection::sendFileInLoop(const boost::shared_ptr<DupFile>& file, off_t offset, size_t length)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected)
+  {
+    LOG_WARN << "disconnected, give up writing";
+    return;  //file析构时关闭
+  }
+  int fd = file->release();
+  setOutputChain(true);  //文件段只能挂在BufferChain上，与之前的数据保持顺序
+  size_t oldLen = outputChain_->readableBytes();
+  if (oldLen + length >= highWaterMark_
+      && oldLen < highWaterMark_
+      && highWaterMarkCallback_)
+  {
+    loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), oldLen + length));
+  }
+  outputChain_->appendFile(fd, offset, length);
+  if (outputChain_->readableBytes() == 0)
+  {
+    if (writeCompleteCallback_) //空文件，没什么可发的
+    {
+      loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+    }
+  }
+  else if (edgeTriggered_)
+  {
+    if (oldLen == 0)
+    {
+      //没有在等EPOLLOUT的边沿，像sendInLoop()一样直接开始发。
+      //这里不走handleWrite()，kDisconnecting时排在后面的数据还没追加，不能先关闭写端
+      ssize_t n = 0;
+      do
+      {
+        n = writeOutput();
+      } while (n >= 0 && outputBytes() > 0);
+      if (outputBytes() == 0 && writeCompleteCallback_)
+      {
+        loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+      }
+    }
+  }
+  else if (!channel_->isWriting())
+  {
+    channel_->enableWriting();  //由handleWrite()调用sendfile(2)，EPOLLOUT时接着发
+  }
+}
+
 void TcpConnection::sendInLoop(const StringPiece& message)
 {
   sendInLoop(message.data(), message.size());
 }
 
 //只能在当前IO线程中send
-void TcpConnection::sendInLoop(const void* data, size_t len)
+void TcpConnection::sendInLoop(const void* data, size_t len, const SharedStringPtr& ref)
 {
   loop_->assertInLoopThread();
   ssize_t nwrote = 0; //表示已被发送至sockfd的数据
@@ -151,9 +404,19 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     return;
   }
   // if no thing in output queue, try writing directly
-  if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0) //Buffer中没数据
+  if (!writing() && outputBytes() == 0) //Buffer中没数据
   {
     nwrote = sockets::write(channel_->fd(), data, len); //直接写入data到socket
+    //ET模式下写到EAGAIN为止，只有这样之后才会有EPOLLOUT的边沿
+    while (edgeTriggered_ && nwrote > 0 && implicit_cast<size_t>(nwrote) < len)
+    {
+      ssize_t n = sockets::write(channel_->fd(), static_cast<const char*>(data)+nwrote, len-nwrote);
+      if (n <= 0)
+      {
+        break;  //出错的话由EPOLLERR和handleWrite()处理
+      }
+      nwrote += n;
+    }
     if (nwrote >= 0)
     {
       remaining = len - nwrote; //调整剩下的字节数
@@ -179,15 +442,27 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
   assert(remaining <= len);
   if (!faultError && remaining > 0)  //如果数据没有一次性发送完毕
   {
-    size_t oldLen = outputBuffer_.readableBytes();
+    size_t oldLen = outputBytes();
     if (oldLen + remaining >= highWaterMark_   
         && oldLen < highWaterMark_
         && highWaterMarkCallback_)  //缓冲数据过多，调用高水位回调函数
     {
       loop_->queueInLoop(boost::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
     }
-    outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining); //将剩下的remaining个数据放入缓冲outputBuffer_
-    if (!channel_->isWriting())
+    if (ref)
+    {
+      setOutputChain(true); //只有BufferChain能挂引用
+      outputChain_->append(ref, nwrote);
+    }
+    else if (outputChain_)
+    {
+      outputChain_->append(static_cast<const char*>(data)+nwrote, remaining); //挂到块链表尾部，不会搬移已缓存的数据
+    }
+    else
+    {
+      outputBuffer_.append(static_cast<const char*>(data)+nwrote, remaining); //将剩下的remaining个数据放入缓冲outputBuffer_
+    }
+    if (!edgeTriggered_ && !channel_->isWriting())
     {
       channel_->enableWriting(); //Buffer中有数据，开始writeable事件.poll返回会在TcpConnection::handleWrite中把缓冲数据发送出去
     }
@@ -209,7 +484,7 @@ void TcpConnection::shutdown()
 void TcpConnection::shutdownInLoop()
 {
   loop_->assertInLoopThread();
-  if (!channel_->isWriting())
+  if (!writing())
   {
     // we are not writing
     socket_->shutdownWrite(); //半关闭，关闭写端
@@ -309,6 +584,11 @@ void TcpConnection::startReadInLoop()
   {
     channel_->enableReading();
     reading_ = true;
+    if (edgeTriggered_)
+    {
+      //停止读期间到达的数据不会再有边沿通知，主动读一次
+      loop_->queueInLoop(boost::bind(&TcpConnection::handleRead, TcpConnectionHandle(this), Timestamp::now()));
+    }
   }
 }
 
@@ -328,6 +608,85 @@ void TcpConnection::stopReadInLoop()
   }
 }
 
+//改用BufferChain作为输出缓冲，已缓存的数据原样搬过去
+void TcpConnection::setOutputChain(bool on)
+{
+  loop_->assertInLoopThread();
+  if (on && !outputChain_)
+  {
+    outputChain_.reset(new BufferChain);
+    outputChain_->append(outputBuffer_.peek(), outputBuffer_.readableBytes());
+    outputBuffer_.retrieveAll();
+  }
+  else if (!on && outputChain_)
+  {
+    outputBuffer_.append(outputChain_->retrieveAllAsString());
+    outputChain_.reset();
+  }
+}
+
+size_t TcpConnection::outputBytes() const
+{
+  return outputChain_ ? outputChain_->readableBytes() : outputBuffer_.readableBytes();
+}
+
+void TcpConnection::setReadBudget(size_t bytes, int messages)
+{
+  assert(bytes > 0 && messages > 0);
+  readBudgetBytes_ = bytes;
+  readBudgetMessages_ = messages;
+}
+
+//本轮循环还能读多少字节，0表示预算用完
+size_t TcpConnection::readBudgetLeft()
+{
+  if (budgetIteration_ != loop_->iteration())
+  {
+    budgetIteration_ = loop_->iteration();
+    bytesThisIteration_ = 0;
+    messagesThisIteration_ = 0;
+  }
+  if (bytesThisIteration_ >= readBudgetBytes_ || messagesThisIteration_ >= readBudgetMessages_)
+  {
+    return 0;
+  }
+  return readBudgetBytes_ - bytesThisIteration_;
+}
+
+void TcpConnection::chargeReadBudget(size_t n)
+{
+  bytesThisIteration_ += n;
+  ++messagesThisIteration_;
+}
+
+//ET模式下EPOLLOUT一直登记着，只看有没有数据没发出去
+bool TcpConnection::writing() const
+{
+  return edgeTriggered_ ? outputBytes() > 0 : channel_->isWriting();
+}
+
+ssize_t TcpConnection::writeOutput()
+{
+  ssize_t n = 0;
+  if (outputChain_)
+  {
+    int savedErrno = 0;
+    n = outputChain_->writeFd(channel_->fd(), &savedErrno);  //一次writev发送多块，并移动读位置
+    errno = savedErrno;
+  }
+  else
+  {
+    n = sockets::write(channel_->fd(),
+                       outputBuffer_.peek(),
+                       outputBuffer_.readableBytes());  //把Buffer缓冲的数据写入sockfd
+    if (n > 0)
+    {
+      outputBuffer_.retrieve(n);  //移动Buffer位置
+    }
+  }
+  return n;
+}
+
 //连接建立。在TcpServer中建立连接后会调用此函数,关注读
 void TcpConnection::connectEstablished()
 {
@@ -335,7 +694,31 @@ void TcpConnection::connectEstablished()
   assert(state_ == kConnecting);
   setState(kConnected);   //状态转换： kConnecting  ->  kConnected
   channel_->tie(shared_from_this());
+  holdsLoopRef_ = addRef();
+  if (sharedReadBuffer_)
+  {
+    inputBuffer_.shrink(0);  //空闲时不占内存
+  }
+  if (edgeTriggered_ && !loop_->supportsEdgeTriggered())
+  {
+    LOG_WARN << "TcpConnection::connectEstablished [" << name()
+             << "] - edge-triggered needs epoll, falls back to level-triggered";
+    edgeTriggered_ = false;
+  }
+  if (edgeTriggered_)
+  {
+    channel_->setEdgeTriggered(true);
+    channel_->enableWriting();  //一直登记着EPOLLOUT，不再来回切换
+  }
   channel_->enableReading();  //开启读事件(加入到Poller关注)
+  if (loop_->busyPollMicroSeconds() > 0 && !t_busyPollFailed)
+  {
+    t_busyPollFailed = !socket_->setBusyPoll(loop_->busyPollMicroSeconds());
+  }
+  if (idleList_)
+  {
+    idleList_->add(this, Timestamp::now());
+  }
 
   connectionCallback_(shared_from_this());  //在此处执行服务端注册的onConnection连接回调
 }
@@ -353,18 +736,43 @@ void TcpConnection::connectDestroyed()
     connectionCallback_(shared_from_this());  //调用到用户定义的的连接回调函数
   }
   channel_->remove(); //将channel_移除,即从epoll中移除fd，该conn在loop中彻底移除
+  if (idleList_)
+  {
+    idleList_->remove(this);
+  }
+  loop_->connectionDestroyed();
+  //内存还给本loop的BufferPool，之后连接可能在别的线程析构
+  inputBuffer_.setPool(NULL);
+  outputBuffer_.setPool(NULL);
+  if (holdsLoopRef_)
+  {
+    holdsLoopRef_ = false;
+    releaseRef(true);  //调用者持有TcpConnectionPtr，不会在这里析构
+  }
 }
 
 //数据到来,调用用户定义的接收信息回调
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
   loop_->assertInLoopThread();
+  if (edgeTriggered_)
+  {
+    handleReadEdgeTriggered(receiveTime);
+    return;
+  }
+  //水平触发每次poll只读一次，每个就绪连接轮流读，不用预算
   int savedErrno = 0;
-  ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+  Buffer* buf = readBuffer();
+  ssize_t n = buf->readFd(channel_->fd(), &savedErrno);
   if (n > 0)  //仍有数据可读
   {
+    if (idleList_)
+    {
+      idleList_->touch(this, receiveTime);  //O(1)，移到空闲链表尾
+    }
       //用户定义的消息到来回调函数在此执行!
-    messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+    runMessageCallback(buf, receiveTime);
+    keepUnread(buf);
   }
   else if (n == 0)  //非阻塞对端关闭了连接则read 0
   {
@@ -378,34 +786,130 @@ void TcpConnection::handleRead(Timestamp receiveTime)
   }
 }
 
+void TcpConnection::runMessageCallback(Buffer* buf, Timestamp receiveTime)
+{
+  if (handleMessageCallback_)
+  {
+    //连接建立期间holdsLoopRef_，这里的引用计数不是原子操作
+    handleMessageCallback_(TcpConnectionHandle(this), buf, receiveTime);
+  }
+  else
+  {
+    messageCallback_(shared_from_this(), buf, receiveTime);
+  }
+}
+
+//共用读缓冲时，没有积压数据的连接读到loop的缓冲中
+Buffer* TcpConnection::readBuffer()
+{
+  if (sharedReadBuffer_ && inputBuffer_.readableBytes() == 0)
+  {
+    Buffer* shared = loop_->sharedReadBuffer();
+    assert(shared->readableBytes() == 0);
+    return shared;
+  }
+  return &inputBuffer_;
+}
+
+//消息回调没有取走的数据(半个消息)留到连接自己的inputBuffer_中
+void TcpConnection::keepUnread(Buffer* buf)
+{
+  if (buf != &inputBuffer_)
+  {
+    inputBuffer_.append(buf->peek(), buf->readableBytes());
+    buf->retrieveAll();
+  }
+}
+
+void TcpConnection::releaseIdleBuffers()
+{
+  loop_->assertInLoopThread();
+  inputBuffer_.shrink(0);  //空的话释放全部内存，否则只留下积压的数据
+  if (outputBuffer_.readableBytes() == 0)
+  {
+    outputBuffer_.shrink(0);
+  }
+}
+
+//ET模式：一直读到EAGAIN，边沿只通知一次
+void TcpConnection::handleReadEdgeTriggered(Timestamp receiveTime)
+{
+  //messageCallback_中可能stopRead()或者关闭连接
+  while (reading_ && (state_ == kConnected || state_ == kDisconnecting))
+  {
+    size_t budget = readBudgetLeft();
+    if (budget == 0)
+    {
+      //还没读到EAGAIN，不会再有边沿通知，下一轮先处理别的就绪连接再接着读
+      loop_->queueDeferred(boost::bind(&TcpConnection::handleRead, TcpConnectionHandle(this), receiveTime));
+      break;
+    }
+    int savedErrno = 0;
+    Buffer* buf = readBuffer();
+    ssize_t n = buf->readFd(channel_->fd(), &savedErrno, budget);
+    if (n > 0)
+    {
+      chargeReadBudget(n);
+      if (idleList_)
+      {
+        idleList_->touch(this, receiveTime);
+      }
+      runMessageCallback(buf, receiveTime);
+      keepUnread(buf);
+    }
+    else if (n == 0)
+    {
+      handleClose();
+      break;
+    }
+    else
+    {
+      if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK)
+      {
+        errno = savedErrno;
+        LOG_SYSERR << "TcpConnection::handleRead";
+        handleError();
+      }
+      break;
+    }
+  }
+}
+
 //处理可写事件
 void TcpConnection::handleWrite()
 {
   loop_->assertInLoopThread();
   if (channel_->isWriting())  //如果sockfd可写触发了可写事件
   {
-    ssize_t n = sockets::write(channel_->fd(),
-                               outputBuffer_.peek(),
-                               outputBuffer_.readableBytes());  //把Buffer缓冲的数据写入sockfd
-    if (n > 0)
+    if (edgeTriggered_ && outputBytes() == 0)
     {
-      outputBuffer_.retrieve(n);  //移动Buffer位置
-      if (outputBuffer_.readableBytes() == 0) //Buffer已经发送完毕了
+      return;  //ET模式下刚登记时和发送缓冲腾出空间时都会通知，没有数据要发
+    }
+    ssize_t n = writeOutput();
+    //ET模式下写到发完或者EAGAIN为止，否则等不到下一次边沿。
+    //文件比sendFile()时短的话sendfile(2)返回0，那一段已经丢弃，也算有进展
+    while (edgeTriggered_ && n >= 0 && outputBytes() > 0)
+    {
+      n = writeOutput();
+    }
+    if (outputBytes() == 0) //Buffer已经发送完毕了
+    {
+      if (!edgeTriggered_)
       {
         channel_->disableWriting(); //先禁用writable事件，否则poll会busy loop
-        if (writeCompleteCallback_) //此处进行写完成回调的函数
-        {
-          loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
-        }
-        //确保了,如果outputBuffer_没有数据了,才关闭连接
-        //避免了本端要发送的数据对端未收到就关闭连接
-        if (state_ == kDisconnecting)
-        {
-          shutdownInLoop();
-        }
+      }
+      if (writeCompleteCallback_) //此处进行写完成回调的函数
+      {
+        loop_->queueInLoop(boost::bind(writeCompleteCallback_, shared_from_this()));
+      }
+      //确保了,如果outputBuffer_没有数据了,才关闭连接
+      //避免了本端要发送的数据对端未收到就关闭连接
+      if (state_ == kDisconnecting)
+      {
+        shutdownInLoop();
       }
     }
-    else
+    else if (n < 0 && (!edgeTriggered_ || (errno != EAGAIN && errno != EWOULDBLOCK)))
     {
       LOG_SYSERR << "TcpConnection::handleWrite";
       // if (state_ == kDisconnecting)
@@ -440,7 +944,7 @@ void TcpConnection::handleClose()
 void TcpConnection::handleError()
 {
   int err = sockets::getSocketError(channel_->fd());
-  LOG_ERROR << "TcpConnection::handleError [" << name_
+  LOG_ERROR << "TcpConnection::handleError [" << name()
             << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
 
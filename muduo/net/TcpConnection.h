@@ -11,10 +11,12 @@
 #ifndef MUDUO_NET_TCPCONNECTION_H
 #define MUDUO_NET_TCPCONNECTION_H
 
+#include <muduo/base/Atomic.h>
 #include <muduo/base/StringPiece.h>
 #include <muduo/base/Types.h>
 #include <muduo/net/Callbacks.h>
 #include <muduo/net/Buffer.h>
+#include <muduo/net/ContextSlots.h>
 #include <muduo/net/InetAddress.h>
 
 #include <boost/any.hpp>
@@ -23,6 +25,10 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <algorithm>
+
+#include <sys/types.h>  // off_t
+
 // struct tcp_info is in <netinet/tcp.h>
 struct tcp_info;
 
@@ -31,8 +37,10 @@ namespace muduo
 namespace net
 {
 
+class BufferChain;
 class Channel;
 class EventLoop;
+class IdleConnectionList;
 class Socket;
 
 ///
@@ -47,18 +55,32 @@ class TcpConnection : boost::noncopyable,
                       public boost::enable_shared_from_this<TcpConnection>
 {
  public:
-  /// Constructs a TcpConnection with a connected sockfd
+  /// Creates a TcpConnection with a connected sockfd
   ///
   /// User should not create this object.
-  TcpConnection(EventLoop* loop,
-                const string& name,
-                int sockfd,
-                const InetAddress& localAddr,
-                const InetAddress& peerAddr);
+  /// The returned TcpConnectionPtr uses release() as its deleter,
+  /// which TcpConnectionHandle relies on.
+  static TcpConnectionPtr create(EventLoop* loop,
+                                 const string& name,
+                                 int sockfd,
+                                 const InetAddress& localAddr,
+                                 const InetAddress& peerAddr);
+  /// Named namePrefix + id, formatted on the first call of name().
+  static TcpConnectionPtr create(EventLoop* loop,
+                                 const boost::shared_ptr<const string>& namePrefix,
+                                 int64_t id,
+                                 int sockfd,
+                                 const InetAddress& localAddr,
+                                 const InetAddress& peerAddr);
   ~TcpConnection();
 
+
   EventLoop* getLoop() const { return loop_; }
-  const string& name() const { return name_; }
+  /// Thread safe.
+  const string& name() const
+  { return nameState_ == kNameReady ? name_ : formatName(); }
+  /// Positive if constructed with an id, eg. by TcpServer.
+  int64_t id() const { return id_; }
   const InetAddress& localAddress() const { return localAddr_; }
   const InetAddress& peerAddress() const { return peerAddr_; }
   bool connected() const { return state_ == kConnected; } //判断是连接建立还是断开
@@ -72,6 +94,14 @@ class TcpConnection : boost::noncopyable,
   void send(const StringPiece& message);
   // void send(Buffer&& message); // C++11
   void send(Buffer* message);  // this one will swap data
+  /// Send a shared immutable message without copying it, the connection
+  /// holds a reference until the kernel takes all bytes.
+  /// Serialize once, then send to many connections, eg. broadcasting.
+  void send(const SharedStringPtr& message);
+  /// Send [offset, offset+length) of file fd with sendfile(2),
+  /// in order with other sends. fd is dup()-ed, caller may close it at once.
+  /// WriteCompleteCallback is called after the file is sent.
+  void sendFile(int fd, off_t offset, size_t length);
   void shutdown(); // NOT thread safe, no simultaneous calling
   // void shutdownAndForceCloseAfter(double seconds); // NOT thread safe, no simultaneous calling
   void forceClose();
@@ -82,6 +112,34 @@ class TcpConnection : boost::noncopyable,
   void stopRead();
   bool isReading() const { return reading_; } // NOT thread safe, may race with start/stopReadInLoop
 
+  /// Queue unsent data in a chain of pooled blocks instead of outputBuffer(),
+  /// and flush it with writev(2). Suits large backlogs, eg. fan-out servers.
+  /// Must be called in loop thread, usually in ConnectionCallback.
+  /// send(const SharedStringPtr&) turns it on when it has to queue.
+  void setOutputChain(bool on);
+  bool isOutputChained() const { return get_pointer(outputChain_) != NULL; }
+
+  /// Edge-triggered only, see setEdgeTriggered().  Reads at most @c bytes and
+  /// calls MessageCallback at most @c messages times per loop iteration before
+  /// reading until EAGAIN, the rest is read after other ready connections and
+  /// pending functors, so that a bulk transfer doesn't hold up small requests
+  /// sharing the loop.  Level-triggered connections read once per poll anyway.
+  /// Not thread safe, usually called in ConnectionCallback.
+  /// Default kDefaultReadBudgetBytes and kDefaultReadBudgetMessages.
+  void setReadBudget(size_t bytes, int messages);
+
+  static const size_t kDefaultReadBudgetBytes = 1024 * 1024;
+  static const int kDefaultReadBudgetMessages = 64;
+
+  /// Reads into a buffer shared by all connections of the loop when
+  /// inputBuffer() is empty, MessageCallback gets that buffer, and bytes it
+  /// leaves are moved to inputBuffer().  So a connection holds no input
+  /// buffer memory between messages.  Don't keep the Buffer* after the
+  /// callback returns.
+  /// Must be called before connectEstablished(), see TcpServer::setSharedReadBuffer().
+  void setSharedReadBuffer(bool on)
+  { sharedReadBuffer_ = on; }
+
   void setContext(const boost::any& context)  //boost::any是一个能保存任意类型值的类
   { context_ = context; }
 
@@ -91,12 +149,20 @@ class TcpConnection : boost::noncopyable,
   boost::any* getMutableContext()
   { return &context_; }
 
+  /// Typed contexts stored inside the connection, faster than getContext().
+  ContextSlots& contexts()
+  { return contexts_; }
+
   void setConnectionCallback(const ConnectionCallback& cb)
   { connectionCallback_ = cb; }
 
   void setMessageCallback(const MessageCallback& cb)
   { messageCallback_ = cb; }
 
+  /// Replaces the MessageCallback if set.
+  void setHandleMessageCallback(const HandleMessageCallback& cb)
+  { handleMessageCallback_ = cb; }
+
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }
 
@@ -107,6 +173,7 @@ class TcpConnection : boost::noncopyable,
   Buffer* inputBuffer()
   { return &inputBuffer_; }
 
+  /// always empty when setOutputChain(true)
   Buffer* outputBuffer()
   { return &outputBuffer_; }
 
@@ -116,22 +183,54 @@ class TcpConnection : boost::noncopyable,
   void setCloseCallback(const CloseCallback& cb)
   { closeCallback_ = cb; }
 
+  /// Internal use only, see TcpServer::setIdleTimeout().
+  void setIdleList(const boost::shared_ptr<IdleConnectionList>& list)
+  { idleList_ = list; }
+
+  /// Internal use only, see TcpServer::setEdgeTriggered().
+  /// Must be called before connectEstablished().
+  void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+  bool edgeTriggered() const { return edgeTriggered_; }
+
   // called when TcpServer accepts a new connection
   void connectEstablished();   // should be called only once
   // called when TcpServer has removed me from its map
   void connectDestroyed();  // should be called only once
 
  private:
+  //只能由create()构造，保证TcpConnectionPtr以release()为deleter
+  //namePrefix为空时名字就是name，否则是namePrefix + id
+  TcpConnection(EventLoop* loop,
+                const boost::shared_ptr<const string>& namePrefix,
+                int64_t id,
+                const string& name,
+                int sockfd,
+                const InetAddress& localAddr,
+                const InetAddress& peerAddr);
+
+  /// Deleter of TcpConnectionPtr, so that a TcpConnectionHandle can outlive
+  /// all TcpConnectionPtr.
+  static void release(TcpConnection* conn);
+
   //枚举了每个TcpConnection对应的几种状态(状态转移参考书籍P317)
   //相关函数：connectEstablished()  shutdown()  handleClose()
   enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
   void handleRead(Timestamp receiveTime); //处理读事件
+  void handleReadEdgeTriggered(Timestamp receiveTime);  //一直读到EAGAIN
+  void runMessageCallback(Buffer* buf, Timestamp receiveTime);
+  Buffer* readBuffer();  //本次读到哪个Buffer
+  void keepUnread(Buffer* buf);
+  void releaseIdleBuffers();  //由IdleConnectionList调用
   void handleWrite(); //处理写事件
   void handleClose(); //处理关闭事件       (这些处理函数都是要传给TcpConnection对应的Channel的)
   void handleError(); //处理错误事件
   // void sendInLoop(string&& message);
   void sendInLoop(const StringPiece& message);
-  void sendInLoop(const void* message, size_t len);
+  void sendInLoop(const void* message, size_t len,
+                  const SharedStringPtr& ref = SharedStringPtr());  //ref非空时未发完的部分只挂引用
+  void sendSharedInLoop(const SharedStringPtr& message);
+  class DupFile;  //sendFile()中dup出来的fd，任务被丢弃时也会关闭
+  void sendFileInLoop(const boost::shared_ptr<DupFile>& file, off_t offset, size_t length);
   void shutdownInLoop();
   // void shutdownAndForceCloseInLoop(double seconds);
   void forceCloseInLoop();  //用于主动关闭连接
@@ -139,11 +238,29 @@ class TcpConnection : boost::noncopyable,
   const char* stateToString() const;
   void startReadInLoop();
   void stopReadInLoop();
+  size_t outputBytes() const;  //outputBuffer_或outputChain_中待发送的字节数
+  ssize_t writeOutput();  //把待发送的数据写一次，出错时errno有效
+  bool writing() const;  //还有数据等着EPOLLOUT之后发送
+  size_t readBudgetLeft();
+  void chargeReadBudget(size_t n);
+
+  enum NameState { kNameEmpty, kNameFormatting, kNameReady };
+  const string& formatName() const;
 
   EventLoop* loop_; //TcpConnection所属的loop
-  const string name_;//连接名称
+  const boost::shared_ptr<const string> namePrefix_;  //同一个TcpServer的连接共用
+  const int64_t id_;
+  mutable string name_;//连接名称，第一次调用name()时才生成
+  mutable volatile int nameState_;  //NameState，多个线程同时调用name()时只有一个去生成
   StateE state_;  // FIXME: use atomic variable
   bool reading_;
+  bool edgeTriggered_;  //EPOLLET，EPOLLOUT一直登记着，读写都到EAGAIN为止
+  // 每轮循环的读预算，用完了ET模式用EventLoop::queueDeferred()推迟到下一轮，LT模式等下一次poll
+  size_t readBudgetBytes_;
+  int readBudgetMessages_;
+  int64_t budgetIteration_;  //下面两个计数属于哪一轮循环
+  size_t bytesThisIteration_;
+  int messagesThisIteration_;
   // we don't expose those classes to client.
   boost::scoped_ptr<Socket> socket_;  //RAII套接字对象
   boost::scoped_ptr<Channel> channel_; //套接字上对应的事件以及处理都将由和套接字对应的Channel来处理
@@ -151,6 +268,7 @@ class TcpConnection : boost::noncopyable,
   const InetAddress peerAddr_;  //对方客户端地址
   ConnectionCallback connectionCallback_; //连接回调
   MessageCallback messageCallback_; //接收消息到达时的回调
+  HandleMessageCallback handleMessageCallback_;  //非空时代替messageCallback_
   WriteCompleteCallback writeCompleteCallback_; // 写完成回调
   HighWaterMarkCallback highWaterMarkCallback_; //outbuffer快满了的高水位回调函数 
   CloseCallback closeCallback_;   // 内部的close回调函数
@@ -161,13 +279,108 @@ class TcpConnection : boost::noncopyable,
   //TcpConnection::send() 来发送数据，outputBuffer是线程安全的
   Buffer inputBuffer_; //保存读取到的sockfd中的数据
   Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer. 当send无法一次性发送完数据后,会先暂存到这里,等下次发送
+  boost::scoped_ptr<BufferChain> outputChain_;  //非空时代替outputBuffer_暂存未发送数据,见setOutputChain()
   boost::any context_;  // boost库的any 可以保持任意的类型 绑定一个未知类型的上下文对象
-  // FIXME: creationTime_, lastReceiveTime_
+  ContextSlots contexts_;  //就地存放的多个有类型的上下文对象
+
+  // 空闲连接链表，由IdleConnectionList维护
+  friend class IdleConnectionList;
+  boost::shared_ptr<IdleConnectionList> idleList_;
+  TcpConnection* idlePrev_;
+  TcpConnection* idleNext_;
+  Timestamp lastReceiveTime_;
+  bool sharedReadBuffer_;  //见setSharedReadBuffer()
+
+  // 侵入式引用计数，见TcpConnectionHandle
+  friend class TcpConnectionHandle;
+  bool addRef();  //在loop线程中只改loopRefs_，返回true
+  void releaseRef(bool loopRef);
+  void releaseShared();
+  int loopRefs_;  //loop线程中的引用，不用原子操作
+  AtomicInt32 refs_;  //其他线程中的引用，加上全部TcpConnectionPtr算1个，loopRefs_>0时算1个
+  bool holdsLoopRef_;  //连接建立期间自己持有一个loop线程引用，loop线程中的handle复制不会碰到refs_
+  // FIXME: creationTime_
   //        bytesReceived_, bytesSent_
 };
 
 typedef boost::shared_ptr<TcpConnection> TcpConnectionPtr;
 
+///
+/// Intrusive reference to a TcpConnection, lighter than TcpConnectionPtr.
+///
+/// 在连接所属的loop线程中复制和析构只改一个普通的int，不用原子操作；
+/// 在其他线程中复制则使用原子引用计数。在loop线程中得到的引用
+/// 如果在其他线程中析构，会转回loop线程释放。
+/// 连接只能由TcpConnection::create()创建，它的TcpConnectionPtr
+/// 以TcpConnection::release()为deleter。
+class TcpConnectionHandle
+{
+ public:
+  TcpConnectionHandle()
+    : conn_(NULL), loopRef_(false)
+  {
+  }
+
+  /// The caller must already hold a reference of @c conn.
+  explicit TcpConnectionHandle(TcpConnection* conn)
+    : conn_(conn), loopRef_(conn != NULL && conn->addRef())
+  {
+  }
+
+  TcpConnectionHandle(const TcpConnectionPtr& conn)  // implicit
+    : conn_(conn.get()), loopRef_(conn_ != NULL && conn_->addRef())
+  {
+  }
+
+  TcpConnectionHandle(const TcpConnectionHandle& rhs)
+    : conn_(rhs.conn_), loopRef_(conn_ != NULL && conn_->addRef())
+  {
+  }
+
+  ~TcpConnectionHandle()
+  {
+    if (conn_)
+    {
+      conn_->releaseRef(loopRef_);
+    }
+  }
+
+  TcpConnectionHandle& operator=(const TcpConnectionHandle& rhs)
+  {
+    TcpConnectionHandle(rhs).swap(*this);
+    return *this;
+  }
+
+  void swap(TcpConnectionHandle& rhs)
+  {
+    std::swap(conn_, rhs.conn_);
+    std::swap(loopRef_, rhs.loopRef_);
+  }
+
+  void reset()
+  {
+    TcpConnectionHandle().swap(*this);
+  }
+
+  TcpConnection* get() const { return conn_; }
+  TcpConnection* operator->() const { return conn_; }
+  TcpConnection& operator*() const { return *conn_; }
+
+  typedef TcpConnection* TcpConnectionHandle::*unspecified_bool_type;
+  operator unspecified_bool_type() const
+  { return conn_ ? &TcpConnectionHandle::conn_ : NULL; }
+
+ private:
+  TcpConnection* conn_;
+  bool loopRef_;  //持有的是loopRefs_中的引用
+};
+
+// for boost::bind
+inline TcpConnection* get_pointer(const TcpConnectionHandle& handle)
+{
+  return handle.get();
+}
+
 }
 }
 
@@ -8,16 +8,16 @@
 
 #include <muduo/net/TcpServer.h>
 
+#include <muduo/base/CountDownLatch.h>
 #include <muduo/base/Logging.h>
 #include <muduo/net/Acceptor.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/IdleConnectionList.h>
 #include <muduo/net/SocketsOps.h>
 
 #include <boost/bind.hpp>
 
-#include <stdio.h>  // snprintf
-
 using namespace muduo;
 using namespace muduo::net;
 
@@ -26,18 +26,33 @@ TcpServer::TcpServer(EventLoop* loop,
                      const string& nameArg,
                      Option option)
   : loop_(CHECK_NOTNULL(loop)), //检查loop非空指针
+    listenAddr_(listenAddr),
+    option_(option),
     ipPort_(listenAddr.toIpPort()), //IP:端口号
     name_(nameArg),  //名称
-    acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)), //Accept的封装,用于获取新连接的fd,供TcpServer使用
+    connNamePrefix_(new string(nameArg + "-" + ipPort_ + "#")),
+    //Accept的封装,用于获取新连接的fd,供TcpServer使用。kReusePortPerLoop时由各IO loop自己accept，有IO线程的话不需要它
+    acceptor_(option == kReusePortPerLoop ? NULL : new Acceptor(loop, listenAddr, option != kNoReusePort)),
     threadPool_(new EventLoopThreadPool(loop, name_)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
-    nextConnId_(1)  //记录连接数，当有新连接的时候会自增
+    perLoopAccept_(false),
+    nextConnId_(1),  //记录连接数，当有新连接的时候会自增
+    idleSeconds_(0.0),
+    bufferReleaseSeconds_(0.0),
+    acceptBudget_(Acceptor::kDefaultAcceptBudget),
+    edgeTriggered_(false),
+    readBudgetBytes_(TcpConnection::kDefaultReadBudgetBytes),
+    readBudgetMessages_(TcpConnection::kDefaultReadBudgetMessages),
+    sharedReadBuffer_(false)
 {
+  if (acceptor_)
+  {
     //Acceptor::handleRead函数中会调用TcpServer::newConnection
     //_1对应的是socket文件描述符，_2对应的是对等方的地址InetAddress
-  acceptor_->setNewConnectionCallback(
-      boost::bind(&TcpServer::newConnection, this, _1, _2));
+    acceptor_->setNewConnectionCallback(
+        boost::bind(&TcpServer::newConnection, this, _1, _2));
+  }
 }
 
 /*
@@ -48,23 +63,98 @@ TcpServer::~TcpServer()
   loop_->assertInLoopThread();
   LOG_TRACE << "TcpServer::~TcpServer [" << name_ << "] destructing";
 
-  for (ConnectionMap::iterator it(connections_.begin());  //在析构函数中销毁connection
-      it != connections_.end(); ++it)
+  if (perLoopAccept_)
+  {
+    //连接在各自的IO线程中移除，在那里停止accept并销毁连接，
+    //才不会和removeConnectionInLoop()交错
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    assert(loops.size() == ioLoopAcceptors_.size());
+    for (size_t i = 0; i < loops.size(); ++i)
+    {
+      CountDownLatch latch(1);
+      loops[i]->runInLoop(
+          boost::bind(&TcpServer::stopInIoLoop, this, loops[i], i, &latch));
+      latch.wait();
+    }
+  }
+
+  for (IdleListMap::iterator it = idleLists_.begin();
+      it != idleLists_.end(); ++it)
+  {
+    it->second->stop();  //链表本身由其中的连接共同持有
+  }
+
+  std::vector<TcpConnectionPtr> connections;
+  {
+  MutexLockGuard lock(mutex_);
+  connections_.takeAll(&connections);
+  }
+  for (size_t i = 0; i < connections.size(); ++i)  //在析构函数中销毁connection
   {
-    TcpConnectionPtr conn = it->second;
-    it->second.reset();
+    TcpConnectionPtr conn;
+    conn.swap(connections[i]);
     conn->getLoop()->runInLoop(
       boost::bind(&TcpConnection::connectDestroyed, conn));
     conn.reset();
   }
 }
 
+//kReusePortPerLoop，ioLoop是第i个IO loop
+void TcpServer::stopInIoLoop(EventLoop* ioLoop, size_t i, CountDownLatch* latch)
+{
+  ioLoop->assertInLoopThread();
+  ioLoopAcceptors_[i].reset();  //Acceptor只能在它所属的loop中析构，之后本loop不会再有新连接
+
+  std::vector<TcpConnectionPtr> connections;
+  {
+  MutexLockGuard lock(mutex_);
+  std::vector<TcpConnectionPtr> all;
+  connections_.takeAll(&all);
+  for (size_t j = 0; j < all.size(); ++j)
+  {
+    if (all[j]->getLoop() == ioLoop)
+    {
+      connections.push_back(all[j]);
+    }
+    else
+    {
+      connections_.insert(all[j]->id(), all[j]);  //其他loop的连接留给它们自己的线程
+    }
+  }
+  }
+  for (size_t j = 0; j < connections.size(); ++j)
+  {
+    connections[j]->connectDestroyed();
+  }
+  latch->countDown();
+}
+
 void TcpServer::setThreadNum(int numThreads)  //设置线程池大小
 {
   assert(0 <= numThreads);
   threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoadBalance(EventLoopThreadPool::LoadBalance policy)
+{
+  threadPool_->setLoadBalance(policy);
+}
+
+void TcpServer::setCpuAffinity(const CpuAffinity& affinity)
+{
+  threadPool_->setCpuAffinity(affinity);
+}
+
+void TcpServer::setAcceptBudget(int n)
+{
+  assert(n > 0);
+  acceptBudget_ = n;
+  if (acceptor_)
+  {
+    acceptor_->setAcceptBudget(n);
+  }
+}
+
 //启动Server，监听客户连接
 void TcpServer::start() 
 {
@@ -72,9 +162,52 @@ void TcpServer::start()
   {
     threadPool_->start(threadInitCallback_);  //启动线程池,创建多个EventLoopThread
 
-    assert(!acceptor_->listenning());
-    loop_->runInLoop(
-        boost::bind(&Acceptor::listen, get_pointer(acceptor_)));  //由mainReactor执行acceptor的listen监听连接
+    if (idleSeconds_ > 0 || bufferReleaseSeconds_ > 0)
+    {
+      std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+      for (size_t i = 0; i < loops.size(); ++i)
+      {
+        boost::shared_ptr<IdleConnectionList> list(
+            new IdleConnectionList(loops[i], idleSeconds_, bufferReleaseSeconds_));
+        list->start();
+        idleLists_[loops[i]] = list;  //之后只在IO线程中find()
+      }
+    }
+
+    std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+    perLoopAccept_ = option_ == kReusePortPerLoop && loops.front() != loop_;
+    if (perLoopAccept_)
+    {
+      //每个IO loop自己listen和accept；先建好全部Acceptor，
+      //再开始listen，之后ioLoopAcceptors_不再改变
+      for (size_t i = 0; i < loops.size(); ++i)
+      {
+        boost::shared_ptr<Acceptor> acceptor(new Acceptor(loops[i], listenAddr_, true));
+        acceptor->setNewConnectionCallback(
+            boost::bind(&TcpServer::newConnectionInIoLoop, this, loops[i], _1, _2));
+        acceptor->setAcceptBudget(acceptBudget_);
+        ioLoopAcceptors_.push_back(acceptor);
+      }
+      for (size_t i = 0; i < loops.size(); ++i)
+      {
+        loops[i]->runInLoop(
+            boost::bind(&Acceptor::listen, get_pointer(ioLoopAcceptors_[i])));
+      }
+    }
+    else
+    {
+      if (!acceptor_)
+      {
+        //kReusePortPerLoop但没有IO线程，和kReusePort一样由base loop accept
+        acceptor_.reset(new Acceptor(loop_, listenAddr_, true));
+        acceptor_->setNewConnectionCallback(
+            boost::bind(&TcpServer::newConnection, this, _1, _2));
+        acceptor_->setAcceptBudget(acceptBudget_);
+      }
+      assert(!acceptor_->listenning());
+      loop_->runInLoop(
+          boost::bind(&Acceptor::listen, get_pointer(acceptor_)));  //由mainReactor执行acceptor的listen监听连接
+    }
   }
 }
 
@@ -86,33 +219,55 @@ EventLoop对象来作为这个新连接的reactor
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
   loop_->assertInLoopThread();
-  EventLoop* ioLoop = threadPool_->getNextLoop(); //在线程池取一个EventLoop对象
-  char buf[64];
-  snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);  //生成这个连接的名字
-  ++nextConnId_;  //连接数+1
-  string connName = name_ + buf;  //组合成连接的一个名字
+  EventLoop* ioLoop = threadPool_->getNextLoop(); //按选定的策略在线程池取一个EventLoop对象
+  createConnection(ioLoop, sockfd, peerAddr);
+}
+
+//kReusePortPerLoop：连接由ioLoop自己的Acceptor接受，直接在本线程建立，不用跨线程转交
+void TcpServer::newConnectionInIoLoop(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr)
+{
+  ioLoop->assertInLoopThread();
+  createConnection(ioLoop, sockfd, peerAddr);
+}
+
+void TcpServer::createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr)
+{
+  int64_t connId = takeConnId();
+  //连接的名字是*connNamePrefix_ + connId，第一次调用TcpConnection::name()时才拼出来
 
   LOG_INFO << "TcpServer::newConnection [" << name_
-           << "] - new connection [" << connName
+           << "] - new connection [" << *connNamePrefix_ << connId
            << "] from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd)); //由sockfd获取sockaddr_in结构
   // FIXME poll with zero timeout to double confirm the new connection
   // FIXME use make_shared if necessary 
   //conn用来管理已连接套接字,由线程池分配的ioLoop负责该conn
-  TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
-  connections_[connName] = conn;  //map,name与conn绑定,conn引用计数变为2
+  TcpConnectionPtr conn(TcpConnection::create(ioLoop,
+                                               connNamePrefix_,
+                                               connId,
+                                               sockfd,
+                                               localAddr,
+                                               peerAddr));
+  addConnection(connId, conn);  //id与conn绑定,conn引用计数变为2
   conn->setConnectionCallback(connectionCallback_); //原样把各个回调函数传给TcpConnectionPtr
   conn->setMessageCallback(messageCallback_);
+  conn->setHandleMessageCallback(handleMessageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
   conn->setCloseCallback(
       boost::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
+  if (!idleLists_.empty())
+  {
+    //可能在多个IO线程中同时查找，不能用operator[]
+    IdleListMap::const_iterator it = idleLists_.find(ioLoop);
+    assert(it != idleLists_.end());
+    conn->setIdleList(it->second);  //在connectEstablished()中加入链表
+  }
+  conn->setEdgeTriggered(edgeTriggered_);
+  conn->setReadBudget(readBudgetBytes_, readBudgetMessages_);
+  conn->setSharedReadBuffer(sharedReadBuffer_);
 
   //由于ioloop所属的IO线程与当前线程不是同一个线程,不能直接调用
-  //要转到ioLoop所属的线程进行调用,因此用runInLoop
+  //要转到ioLoop所属的线程进行调用,因此用runInLoop(kReusePortPerLoop时就是当前线程,直接调用)
   //将新到来的连接conn加入到线程池分配的ioLoop的监听事件中
   ioLoop->runInLoop(boost::bind(&TcpConnection::connectEstablished, conn));
 }
@@ -122,15 +277,23 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
 {
   // FIXME: unsafe
-  loop_->runInLoop(boost::bind(&TcpServer::removeConnectionInLoop, this, conn));
+  if (!perLoopAccept_)
+  {
+    loop_->runInLoop(boost::bind(&TcpServer::removeConnectionInLoop, this, conn));
+  }
+  else
+  {
+    removeConnectionInLoop(conn);  //kReusePortPerLoop时不经过base loop，在conn所在的IO线程中移除
+  }
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
 {
-  loop_->assertInLoopThread();
+  assert(perLoopAccept_ ? conn->getLoop()->isInLoopThread()
+                        : loop_->isInLoopThread());
   LOG_INFO << "TcpServer::removeConnectionInLoop [" << name_
-           << "] - connection " << conn->name();
-  size_t n = connections_.erase(conn->name());  //根据connection的名字从列表中移除TcpConnectionPtr
+           << "] - connection " << *connNamePrefix_ << conn->id();
+  size_t n = eraseConnection(conn->id());  //根据connection的id从列表中移除TcpConnectionPtr
   (void)n;
   assert(n == 1);
   EventLoop* ioLoop = conn->getLoop();//取出conn所属的IO线程
@@ -138,3 +301,36 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
       boost::bind(&TcpConnection::connectDestroyed, conn));//在IO线程中销毁连接
 }
 
+int64_t TcpServer::takeConnId()
+{
+  if (perLoopAccept_)
+  {
+    MutexLockGuard lock(mutex_);
+    return nextConnId_++;
+  }
+  loop_->assertInLoopThread();
+  return nextConnId_++;  //连接数+1
+}
+
+void TcpServer::addConnection(int64_t connId, const TcpConnectionPtr& conn)
+{
+  if (perLoopAccept_)
+  {
+    MutexLockGuard lock(mutex_);
+    connections_.insert(connId, conn);
+  }
+  else
+  {
+    connections_.insert(connId, conn);
+  }
+}
+
+size_t TcpServer::eraseConnection(int64_t connId)
+{
+  if (perLoopAccept_)
+  {
+    MutexLockGuard lock(mutex_);
+    return connections_.erase(connId);
+  }
+  return connections_.erase(connId);
+}
@@ -12,22 +12,28 @@
 #define MUDUO_NET_TCPSERVER_H
 
 #include <muduo/base/Atomic.h>
+#include <muduo/base/Mutex.h>
 #include <muduo/base/Types.h>
+#include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/IdMap.h>
 #include <muduo/net/TcpConnection.h>
 
 #include <map>
+#include <vector>
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
 namespace muduo
 {
+class CountDownLatch;
+
 namespace net
 {
 
 class Acceptor;
 class EventLoop;
-class EventLoopThreadPool;
+class IdleConnectionList;
 
 ///
 /// TCP server, supports single-threaded and thread-pool models.
@@ -43,6 +49,7 @@ class TcpServer : boost::noncopyable
   {
     kNoReusePort,
     kReusePort,
+    kReusePortPerLoop,  //每个IO loop一个SO_REUSEPORT的Acceptor，由内核分发新连接
   };
 
   //TcpServer(EventLoop* loop, const InetAddress& listenAddr);
@@ -66,13 +73,63 @@ class TcpServer : boost::noncopyable
   /// - 1 means all I/O in another thread.
   /// - N means a thread pool with N threads, new connections
   ///   are assigned on a round-robin basis.
+  ///   With kReusePortPerLoop, each of the N threads accepts on its own
+  ///   listening socket instead, the kernel spreads new connections.
   void setThreadNum(int numThreads);  //该接口用来设置server中需要运行多少个loop线程
+  /// How new connections are assigned to the N threads, round-robin by default.
+  /// Not used with kReusePortPerLoop.
+  void setLoadBalance(EventLoopThreadPool::LoadBalance policy);
+  /// Where the N threads run, eg. CpuAffinity::sameNodeAs("eth0").
+  /// With kReusePortPerLoop connections are also created in their IO thread,
+  /// so their Buffers come from node-local memory too.
+  void setCpuAffinity(const CpuAffinity& affinity);
   void setThreadInitCallback(const ThreadInitCallback& cb)
   { threadInitCallback_ = cb; }
   /// valid after calling start()
   boost::shared_ptr<EventLoopThreadPool> threadPool()
   { return threadPool_; }
 
+  /// Closes connections which receive nothing for @c seconds.
+  ///
+  /// One coarse timer per IO loop, O(1) per message, no allocation.
+  /// Idle connections are closed within one more second.
+  /// Must be called before @c start
+  void setIdleTimeout(double seconds)
+  { idleSeconds_ = seconds; }
+
+  /// Frees the input and output buffers of connections which receive
+  /// nothing for @c seconds, they are allocated again on the next message.
+  /// Shares the timer and list of setIdleTimeout().
+  /// Must be called before @c start
+  void setBufferReleaseTimeout(double seconds)
+  { bufferReleaseSeconds_ = seconds; }
+
+  /// See TcpConnection::setSharedReadBuffer().
+  /// With setBufferReleaseTimeout(), idle connections hold no buffer memory.
+  /// Must be called before @c start
+  void setSharedReadBuffer(bool on)
+  { sharedReadBuffer_ = on; }
+
+  /// Registers connections with EPOLLET instead of level-triggered.
+  ///
+  /// Reads and writes go on until EAGAIN, EPOLLOUT stays registered,
+  /// fewer wakeups and epoll_ctl(2) calls with many connections.
+  /// Needs the default epoll poller, ignored otherwise.
+  /// Must be called before @c start
+  void setEdgeTriggered(bool on)
+  { edgeTriggered_ = on; }
+
+  /// See TcpConnection::setReadBudget(), only used with setEdgeTriggered().
+  /// Must be called before @c start
+  void setReadBudget(size_t bytes, int messages)
+  { readBudgetBytes_ = bytes; readBudgetMessages_ = messages; }
+
+  /// Accepts at most @c n connections per wakeup of the listening socket.
+  ///
+  /// Default Acceptor::kDefaultAcceptBudget.
+  /// Must be called before @c start
+  void setAcceptBudget(int n);
+
   /// Starts the server if it's not listenning.
   ///
   /// It's harmless to call it multiple times.
@@ -89,6 +146,11 @@ class TcpServer : boost::noncopyable
   void setMessageCallback(const MessageCallback& cb)  //保存用户自定义消息回调
   { messageCallback_ = cb; }
 
+  /// Set message callback taking TcpConnectionHandle, replaces MessageCallback.
+  /// Not thread safe.
+  void setHandleMessageCallback(const HandleMessageCallback& cb)
+  { handleMessageCallback_ = cb; }
+
   /// Set write complete callback.
   /// Not thread safe.
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)  //调用该接口用来设置用户自定义写完成回调
@@ -97,29 +159,56 @@ class TcpServer : boost::noncopyable
  private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);  
+  /// kReusePortPerLoop, in ioLoop
+  void newConnectionInIoLoop(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
+  /// Thread safe.
+  void createConnection(EventLoop* ioLoop, int sockfd, const InetAddress& peerAddr);
   /// Thread safe.
   /// 通知TcpServer移除所持有的TcpConnectionPtr
   void removeConnection(const TcpConnectionPtr& conn);
   /// Not thread safe, but in loop
   void removeConnectionInLoop(const TcpConnectionPtr& conn);
+  /// kReusePortPerLoop, in ioLoop
+  void stopInIoLoop(EventLoop* ioLoop, size_t i, CountDownLatch* latch);
+  // 以下访问nextConnId_和connections_，只在perLoopAccept_时加锁
+  int64_t takeConnId();
+  void addConnection(int64_t connId, const TcpConnectionPtr& conn);
+  size_t eraseConnection(int64_t connId);
 
-  typedef std::map<string, TcpConnectionPtr> ConnectionMap; //通过每一个连接的名字来找到对应的连接来维护管理TcpConnection的
+  typedef IdMap<TcpConnectionPtr> ConnectionMap; //以TcpConnection::id()为key，接受连接时不用拼名字
+  typedef std::map<EventLoop*, boost::shared_ptr<IdleConnectionList> > IdleListMap;
 
   EventLoop* loop_;  // mainReactor Loop. acceptor来接受连接，而新连接会用线程池返回的subReactor EventLoop来执行IO
+  const InetAddress listenAddr_;
+  const Option option_;
   const string ipPort_; //ip:端口号
   const string name_; //主机名,为创建TcpServer时传入
+  const boost::shared_ptr<const string> connNamePrefix_;  //"name_-ipPort_#"，所有连接共用
   boost::scoped_ptr<Acceptor> acceptor_; // avoid revealing Acceptor 使用该类来创建、监听连接，并通过处理该套接字来获得新连接sockfd
+  std::vector<boost::shared_ptr<Acceptor> > ioLoopAcceptors_;  // kReusePortPerLoop时与threadPool_->getAllLoops()一一对应
   boost::shared_ptr<EventLoopThreadPool> threadPool_; //实现多个one loop per thread
   //相关回调函数设置
   ConnectionCallback connectionCallback_;
   MessageCallback messageCallback_;
+  HandleMessageCallback handleMessageCallback_;
   WriteCompleteCallback writeCompleteCallback_;
   ThreadInitCallback threadInitCallback_;
 
   AtomicInt32 started_;
-  // always in loop thread
-  int nextConnId_;  //记录连接数，当有新连接的时候会自增
-  ConnectionMap connections_; //Map的key为connection的name(name与TcpConnectionPtr作映射)
+  //kReusePortPerLoop且有IO线程时为true，start()中在任何Acceptor开始listen之前确定，之后不变
+  bool perLoopAccept_;
+  //perLoopAccept_时会在多个IO线程中访问，否则只在loop_中访问，不用加锁
+  MutexLock mutex_;
+  int64_t nextConnId_;  //记录连接数，当有新连接的时候会自增  @GuardedBy mutex_
+  ConnectionMap connections_; //key为连接的id  @GuardedBy mutex_
+  double idleSeconds_;  //大于0时启用空闲连接超时
+  double bufferReleaseSeconds_;  //大于0时释放空闲连接的Buffer
+  IdleListMap idleLists_;  //每个IO loop一个空闲连接链表，start()之后不再改变
+  int acceptBudget_;  //每次可读时最多accept几个连接
+  bool edgeTriggered_;
+  size_t readBudgetBytes_;
+  int readBudgetMessages_;
+  bool sharedReadBuffer_;
 };                             //用来管理维护这些连接
 
 }
@@ -34,7 +34,10 @@ class Timer : boost::noncopyable
       expiration_(when),  //超时时间
       interval_(interval),  //如果重复，间隔时间
       repeat_(interval > 0.0),  //是否重复
-      sequence_(s_numCreated_.incrementAndGet())  //设置当前定时器序列号，原子操作,先加后获取
+      sequence_(s_numCreated_.incrementAndGet()),  //设置当前定时器序列号，原子操作,先加后获取
+      prev_(NULL),
+      next_(NULL),
+      tick_(0)
   { }
 
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
@@ -43,7 +46,10 @@ class Timer : boost::noncopyable
       expiration_(when),
       interval_(interval),
       repeat_(interval > 0.0),
-      sequence_(s_numCreated_.incrementAndGet())
+      sequence_(s_numCreated_.incrementAndGet()),
+      prev_(NULL),
+      next_(NULL),
+      tick_(0)
   { }
 #endif
 
@@ -53,6 +59,9 @@ class Timer : boost::noncopyable
     callback_();
   }
 
+  //回调的类型名，统计最慢回调时用来辨认是哪个定时器
+  const char* callbackName() const { return callback_.target_type().name(); }
+
   Timestamp expiration() const  { return expiration_; }  //返回定时器的闹铃时间
   bool repeat() const { return repeat_; }   //是否重复设置定时器
   int64_t sequence() const { return sequence_; }    //定时器序列号
@@ -68,6 +77,12 @@ class Timer : boost::noncopyable
   const bool repeat_;   //是否重复定时
   const int64_t sequence_;    //Timer序号,从s_numCreated_获取
 
+  // TimingWheel用：同一个槽中的定时器串成双向链表，tick_是到期的刻度
+  friend class TimingWheel;
+  Timer* prev_;
+  Timer* next_;
+  int64_t tick_;
+
   static AtomicInt64 s_numCreated_;   //Timer计数，当前已经创建的定时器数量
 };  
 }
@@ -14,8 +14,10 @@
 
 #include <muduo/base/Logging.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/LoopStats.h>
 #include <muduo/net/Timer.h>
 #include <muduo/net/TimerId.h>
+#include <muduo/net/TimingWheel.h>
 
 #include <boost/bind.hpp>
 
@@ -146,9 +148,27 @@ void TimerQueue::cancel(TimerId timerId)
       boost::bind(&TimerQueue::cancelInLoop, this, timerId));
 }
 
+void TimerQueue::setTimingWheel(double tick, int numSlots)
+{
+  loop_->assertInLoopThread();
+  assert(timers_.empty() && !wheel_);
+  wheel_.reset(new TimingWheel(tick, numSlots, Timestamp::now()));
+}
+
 void TimerQueue::addTimerInLoop(Timer* timer)
 {
   loop_->assertInLoopThread();
+  if (wheel_)
+  {
+    //轮子上有定时器时timerfd每个tick响一次，空轮子不用转
+    bool wasEmpty = wheel_->empty();
+    wheel_->insert(timer);
+    if (wasEmpty)
+    {
+      resetTimerfd(timerfd_, wheel_->nextTick(Timestamp::now()));
+    }
+    return;
+  }
   bool earliestChanged = insert(timer); //插入一个定时器，有可能会使得最早到期的定时器发生改变（插入的时间更小时）
 
   if (earliestChanged)  //要插入的timer是最早超时的定时器
@@ -160,6 +180,14 @@ void TimerQueue::addTimerInLoop(Timer* timer)
 void TimerQueue::cancelInLoop(TimerId timerId)
 {
   loop_->assertInLoopThread();
+  if (wheel_)
+  {
+    if (!wheel_->cancel(timerId.timer_, timerId.sequence_) && callingExpiredTimers_)
+    {
+      cancelingTimers_.insert(ActiveTimer(timerId.timer_, timerId.sequence_));
+    }
+    return;
+  }
   assert(timers_.size() == activeTimers_.size()); //相等的。这两个容器保存的是相同的数据，timers_是按到期时间排序，activeTimers_按对象地址排序
   ActiveTimer timer(timerId.timer_, timerId.sequence_); //获取TimerId的Timer*和其序列号给timer
   ActiveTimerSet::iterator it = activeTimers_.find(timer);  //寻找要取消的timer是否在activeTimers_中
@@ -183,6 +211,11 @@ void TimerQueue::handleRead()
   loop_->assertInLoopThread();
   Timestamp now(Timestamp::now());
   readTimerfd(timerfd_, now);   //必须要读取timerfd，否则会一直返回就绪事件
+  if (wheel_)
+  {
+    handleWheel(now);
+    return;
+  }
 
   std::vector<Entry> expired = getExpired(now); //找到now之前所有超时的定时器列表
 
@@ -192,13 +225,59 @@ void TimerQueue::handleRead()
   for (std::vector<Entry>::iterator it = expired.begin();
       it != expired.end(); ++it)
   {
-    it->second->run();    //对所有超时的定时器expired执行对应的超时回调函数
+    runTimer(it->second);    //对所有超时的定时器expired执行对应的超时回调函数
   }
   callingExpiredTimers_ = false;    //超时回调结束，清空标志位
 
   reset(expired, now);    //把要重复运行的定时器重新加入到定时器集合中
 }
 
+//执行定时器回调，并把耗时计入loop的统计
+void TimerQueue::runTimer(Timer* timer)
+{
+  Timestamp start(Timestamp::now());
+  timer->run();
+  int64_t micros = Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch();
+  loop_->stats()->recordTimer(timer->callbackName(), micros);
+}
+
+//与handleRead()和reset()相同，只是定时器来自时间轮
+void TimerQueue::handleWheel(Timestamp now)
+{
+  std::vector<Timer*> expired;
+  wheel_->getExpired(now, &expired);
+
+  callingExpiredTimers_ = true;
+  cancelingTimers_.clear();
+  for (std::vector<Timer*>::iterator it = expired.begin();
+      it != expired.end(); ++it)
+  {
+    runTimer(*it);
+  }
+  callingExpiredTimers_ = false;
+
+  for (std::vector<Timer*>::iterator it = expired.begin();
+      it != expired.end(); ++it)
+  {
+    ActiveTimer timer(*it, (*it)->sequence());
+    if ((*it)->repeat()
+        && cancelingTimers_.find(timer) == cancelingTimers_.end())
+    {
+      (*it)->restart(now);
+      wheel_->insert(*it);
+    }
+    else
+    {
+      delete *it;
+    }
+  }
+
+  if (!wheel_->empty())
+  {
+    resetTimerfd(timerfd_, wheel_->nextTick(now));
+  }
+}
+
 //找到now之前的所有超时的定时器列表
 //并把超时的定时器从集合中删除
 std::vector<TimerQueue::Entry> TimerQueue::getExpired(Timestamp now)
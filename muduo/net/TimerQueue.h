@@ -15,6 +15,7 @@
 #include <vector>
 
 #include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Timestamp.h>
@@ -29,6 +30,7 @@ namespace net
 class EventLoop;
 class Timer;
 class TimerId;
+class TimingWheel;
 
 ///
 /// A best efforts timer queue.
@@ -59,6 +61,13 @@ class TimerQueue : boost::noncopyable
   //取消定时器，线程安全
   void cancel(TimerId timerId);
 
+  ///
+  /// Keeps timers in a hashed TimingWheel instead of std::set,
+  /// add and cancel become O(1), timers fire at @c tick granularity.
+  ///
+  /// Must be called in the loop thread, before adding any timer.
+  void setTimingWheel(double tick, int numSlots);
+
  private:
 
   // FIXME: use unique_ptr<Timer> instead of raw pointers.
@@ -76,6 +85,8 @@ class TimerQueue : boost::noncopyable
   // move out all expired timers
   std::vector<Entry> getExpired(Timestamp now); //返回超时的定时器列表,并把超时的定时器从集合中删除
   void reset(const std::vector<Entry>& expired, Timestamp now);//把要重复运行的定时器重新加入到定时器集合中
+  void handleWheel(Timestamp now);  //时间轮模式下处理超时的定时器
+  void runTimer(Timer* timer);  //执行一个定时器回调并统计耗时
 
   bool insert(Timer* timer);// 插入定时器
 
@@ -89,6 +100,9 @@ class TimerQueue : boost::noncopyable
   ActiveTimerSet activeTimers_;//定时器集合,按照Timer* 地址大小来排序
   bool callingExpiredTimers_; /* atomic */  //是否正在处理超时定时事件
   ActiveTimerSet cancelingTimers_;  //保存要取消的定时器的集合(如果不在定时器集合中,而是属于在执行超时回调的定时器)
+
+  // 非空时所有定时器都在时间轮上，timers_和activeTimers_不再使用
+  boost::scoped_ptr<TimingWheel> wheel_;
 };
 
 }
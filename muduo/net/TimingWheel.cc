@@ -0,0 +1,137 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/TimingWheel.h>
+
+#include <muduo/net/Timer.h>
+
+#include <algorithm>
+
+#include <assert.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+TimingWheel::TimingWheel(double tick, int numSlots, Timestamp start)
+  : tickMicroSeconds_(std::max(static_cast<int64_t>(tick * Timestamp::kMicroSecondsPerSecond),
+                               static_cast<int64_t>(1))),
+    start_(start),
+    currentTick_(0),
+    slots_(numSlots, static_cast<Timer*>(NULL))
+{
+  assert(numSlots > 0);
+}
+
+TimingWheel::~TimingWheel()
+{
+  for (TimerMap::iterator it = timers_.begin(); it != timers_.end(); ++it)
+  {
+    delete it->second;
+  }
+}
+
+int64_t TimingWheel::tickOf(Timestamp when) const
+{
+  int64_t diff = when.microSecondsSinceEpoch() - start_.microSecondsSinceEpoch();
+  if (diff <= 0)
+  {
+    return 0;
+  }
+  return (diff + tickMicroSeconds_ - 1) / tickMicroSeconds_;
+}
+
+Timestamp TimingWheel::nextTick(Timestamp now) const
+{
+  int64_t diff = now.microSecondsSinceEpoch() - start_.microSecondsSinceEpoch();
+  int64_t tick = std::max(diff / tickMicroSeconds_, currentTick_) + 1;
+  return Timestamp(start_.microSecondsSinceEpoch() + tick * tickMicroSeconds_);
+}
+
+void TimingWheel::insert(Timer* timer)
+{
+  //已经过期的放到下一个刻度
+  timer->tick_ = std::max(tickOf(timer->expiration()), currentTick_ + 1);
+  link(timer);
+  bool inserted = timers_.insert(TimerMap::value_type(timer->sequence(), timer)).second;
+  assert(inserted); (void)inserted;
+}
+
+bool TimingWheel::cancel(Timer* timer, int64_t sequence)
+{
+  TimerMap::iterator it = timers_.find(sequence);
+  if (it != timers_.end())
+  {
+    assert(it->second == timer); (void)timer;
+    unlink(it->second);
+    delete it->second;
+    timers_.erase(it);
+    return true;
+  }
+  return false;
+}
+
+//从上次处理到的刻度一直转到now所在的刻度，最多转一圈
+void TimingWheel::getExpired(Timestamp now, std::vector<Timer*>* expired)
+{
+  int64_t diff = now.microSecondsSinceEpoch() - start_.microSecondsSinceEpoch();
+  int64_t nowTick = diff / tickMicroSeconds_;
+  if (nowTick <= currentTick_)
+  {
+    return;
+  }
+  int64_t steps = std::min(nowTick - currentTick_, static_cast<int64_t>(slots_.size()));
+  for (int64_t i = 1; i <= steps; ++i)
+  {
+    Timer* timer = slots_[(currentTick_ + i) % slots_.size()];
+    while (timer)
+    {
+      Timer* next = timer->next_;
+      if (timer->tick_ <= nowTick)
+      {
+        unlink(timer);
+        size_t n = timers_.erase(timer->sequence());
+        assert(n == 1); (void)n;
+        expired->push_back(timer);
+      }
+      timer = next;
+    }
+  }
+  currentTick_ = nowTick;
+}
+
+void TimingWheel::link(Timer* timer)
+{
+  Timer*& head = slots_[timer->tick_ % slots_.size()];
+  timer->prev_ = NULL;
+  timer->next_ = head;
+  if (head)
+  {
+    head->prev_ = timer;
+  }
+  head = timer;
+}
+
+void TimingWheel::unlink(Timer* timer)
+{
+  if (timer->prev_)
+  {
+    timer->prev_->next_ = timer->next_;
+  }
+  else
+  {
+    Timer*& head = slots_[timer->tick_ % slots_.size()];
+    assert(head == timer);
+    head = timer->next_;
+  }
+  if (timer->next_)
+  {
+    timer->next_->prev_ = timer->prev_;
+  }
+  timer->prev_ = NULL;
+  timer->next_ = NULL;
+}
@@ -0,0 +1,71 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_TIMINGWHEEL_H
+#define MUDUO_NET_TIMINGWHEEL_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <muduo/base/Timestamp.h>
+
+namespace muduo
+{
+namespace net
+{
+
+class Timer;
+
+///
+/// Hashed timing wheel, O(1) insert and cancel.
+///
+/// 时间轴按tick分成刻度，第k个刻度落在槽k % numSlots中，
+/// 一个槽里的定时器串成双向链表，比轮子一圈还远的定时器也放在同一个槽里，
+/// 转到时只取出刻度已到的那些。定时器最多晚一个tick到期，不会提前。
+/// 只在所属IO线程中使用，由TimerQueue的timerfd驱动。
+class TimingWheel : boost::noncopyable
+{
+ public:
+  TimingWheel(double tick, int numSlots, Timestamp start);
+  ~TimingWheel();  //删除还在轮子上的定时器
+
+  /// Takes ownership of timer.
+  void insert(Timer* timer);
+  /// Deletes the timer if it's still in the wheel.
+  /// @return false if not found, eg. already expired.
+  bool cancel(Timer* timer, int64_t sequence);
+  /// Moves out timers expired at now, ownership is passed to caller.
+  void getExpired(Timestamp now, std::vector<Timer*>* expired);
+
+  size_t size() const { return timers_.size(); }
+  bool empty() const { return timers_.empty(); }
+
+  /// Time of the next tick after now.
+  Timestamp nextTick(Timestamp now) const;
+
+ private:
+  int64_t tickOf(Timestamp when) const;  // when落在哪个刻度，向上取整
+  void link(Timer* timer);
+  void unlink(Timer* timer);
+
+  typedef boost::unordered_map<int64_t, Timer*> TimerMap;  // sequence -> Timer*，用于cancel()
+
+  const int64_t tickMicroSeconds_;
+  const Timestamp start_;  //第0个刻度的时间
+  int64_t currentTick_;  //已经处理到的刻度
+  std::vector<Timer*> slots_;  //每个槽中链表的头
+  TimerMap timers_;
+};
+
+}
+}
+#endif  // MUDUO_NET_TIMINGWHEEL_H
@@ -68,7 +68,7 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
       //初始状态是处于解析请求行的状态，下一次循环不是该状态就不会进入，一般只进入一次
     if (state_ == kExpectRequestLine)
     {
-      const char* crlf = buf->findCRLF();  //首先查找\r\n，就会到GET / HTTP/1.1的请求行末尾 
+      const char* crlf = buf->findCRLF(&scanned_);  //首先查找\r\n，就会到GET / HTTP/1.1的请求行末尾 
       if (crlf)  
       {
         ok = processRequestLine(buf->peek(), crlf); //解析请求行
@@ -76,6 +76,7 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
         {
           request_.setReceiveTime(receiveTime); //设置解析请求行完毕的时间
           buf->retrieveUntil(crlf + 2);  //移动buf偏移量(将请求行从buf中取出，包括\r\n)
+          scanned_ = 0;
           state_ = kExpectHeaders;  //将Httpontext状态改为KexpectHeaders状态
         }
         else
@@ -91,7 +92,7 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
     //处于要解析Header状态
     else if (state_ == kExpectHeaders)
     {
-      const char* crlf = buf->findCRLF();  //查找\r\n位置
+      const char* crlf = buf->findCRLF(&scanned_);  //查找\r\n位置
       if (crlf)
       {
         const char* colon = std::find(buf->peek(), crlf, ':');  //查找:(请求头形式： 字段名: 具体值)
@@ -107,6 +108,7 @@ bool HttpContext::parseRequest(Buffer* buf, Timestamp receiveTime)
           hasMore = false;
         }
         buf->retrieveUntil(crlf + 2);  //请求完毕,移动Buffer索引位置
+        scanned_ = 0;
       }
       else
       {
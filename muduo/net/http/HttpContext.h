@@ -35,7 +35,8 @@ class HttpContext : public muduo::copyable
   };
 
   HttpContext()
-    : state_(kExpectRequestLine)   //初始状态，期望收到一个请求行
+    : state_(kExpectRequestLine),   //初始状态，期望收到一个请求行
+      scanned_(0)
   {
   }
 
@@ -52,6 +53,7 @@ class HttpContext : public muduo::copyable
   void reset()
   {
     state_ = kExpectRequestLine;
+    scanned_ = 0;
     HttpRequest dummy;  //构造一个临时空HttpRequest对象，
     request_.swap(dummy);//和当前的成员HttpRequest对象交换置空，然后临时对象析构
   }
@@ -66,6 +68,7 @@ class HttpContext : public muduo::copyable
   bool processRequestLine(const char* begin, const char* end);  //解析请求行
 
   HttpRequestParseState state_;  // 请求解析状态
+  size_t scanned_;  //当前行已经找过\r\n的字节数，见Buffer::findCRLF(size_t*)
   HttpRequest request_;  // http请求
 };
 
@@ -68,8 +68,8 @@ void HttpServer::onConnection(const TcpConnectionPtr& conn)
 {
   if (conn->connected())
   {
-    //构造一个http上下文对象，用来解析http请求，利用boost::any保存至TcpConnection上下文中
-    conn->setContext(HttpContext());  
+    //构造一个http上下文对象，用来解析http请求，就地保存在TcpConnection的kCodecSlot中
+    conn->contexts().set(ContextSlots::kCodecSlot, HttpContext());
   }
 }
 
@@ -80,7 +80,7 @@ void HttpServer::onMessage(const TcpConnectionPtr& conn,
                            Buffer* buf,
                            Timestamp receiveTime)
 {
-  HttpContext* context = boost::any_cast<HttpContext>(conn->getMutableContext());  //取出请求，mutable可以改变
+  HttpContext* context = conn->contexts().get<HttpContext>(ContextSlots::kCodecSlot);  //取出请求，可以改变
 
   if (!context->parseRequest(buf, receiveTime))  //调用context的parseRequest解析请求，判断请求是否合法
   {
@@ -14,6 +14,7 @@
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/http/HttpRequest.h>
 #include <muduo/net/http/HttpResponse.h>
+#include <muduo/net/inspect/NetInspector.h>
 #include <muduo/net/inspect/ProcessInspector.h>
 #include <muduo/net/inspect/PerformanceInspector.h>
 #include <muduo/net/inspect/SystemInspector.h>
@@ -67,7 +68,8 @@ Inspector::Inspector(EventLoop* loop,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:"+name),   //初始化http服务器
       processInspector_(new ProcessInspector),       //进程检查器
-      systemInspector_(new SystemInspector)         //系统检查器
+      systemInspector_(new SystemInspector),        //系统检查器
+      netInspector_(new NetInspector)               //网络库检查器
 {
   assert(CurrentThread::isMainThread());  //断言在主线程当中 
   assert(g_globalInspector == 0);
@@ -75,6 +77,7 @@ Inspector::Inspector(EventLoop* loop,
   server_.setHttpCallback(boost::bind(&Inspector::onRequest, this, _1, _2));  /*设置请求的回调函数，这里的请求是完成了协议的解析之后*/
   processInspector_->registerCommands(this);  //注册命令，实际上就是填充两个map对应的命令，回调函数，help信息
   systemInspector_->registerCommands(this);
+  netInspector_->registerCommands(this);
 #ifdef HAVE_TCMALLOC
   performanceInspector_.reset(new PerformanceInspector);
   performanceInspector_->registerCommands(this);
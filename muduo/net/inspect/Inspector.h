@@ -25,6 +25,7 @@ namespace muduo
 namespace net
 {
 
+class NetInspector;
 class ProcessInspector;
 class PerformanceInspector;
 class SystemInspector;
@@ -62,6 +63,7 @@ class Inspector : boost::noncopyable
   boost::scoped_ptr<ProcessInspector> processInspector_;    //暴露的接口，进程模块
   boost::scoped_ptr<PerformanceInspector> performanceInspector_;    //性能模块
   boost::scoped_ptr<SystemInspector> systemInspector_;  //系统模块
+  boost::scoped_ptr<NetInspector> netInspector_;  //网络库模块
   MutexLock mutex_;
   std::map<string, CommandList> modules_;   //模块,对应module -- command -- callback
   std::map<string, HelpList> helps_;    //帮助，对应于module -- command -- help
@@ -0,0 +1,235 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include <muduo/net/inspect/NetInspector.h>
+#include <muduo/net/Acceptor.h>
+#include <muduo/net/BufferPool.h>
+#include <muduo/net/LoopStats.h>
+
+#include <boost/bind.hpp>
+
+#include <cxxabi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace muduo
+{
+namespace inspect
+{
+
+int stringPrintf(string* out, const char* fmt, ...) __attribute__ ((format (printf, 2, 3)));
+
+}
+}
+
+using namespace muduo::inspect;
+
+namespace
+{
+
+//boost::bind出来的类型名很长，截断一下
+string demangle(const char* name)
+{
+  if (name == NULL)
+  {
+    return "";
+  }
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+  string result(status == 0 && demangled ? demangled : name);
+  free(demangled);
+  const size_t kMaxLength = 200;
+  if (result.size() > kMaxLength)
+  {
+    result.resize(kMaxLength);
+    result += "...";
+  }
+  return result;
+}
+
+double percentOf(int64_t part, int64_t total)
+{
+  return total > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(total) : 0.0;
+}
+
+void printHistogram(string* out, const char* title, const Histogram& h, int64_t total)
+{
+  stringPrintf(out, "  %-16s %10.3f %6.2f%% %10lld %8lld %8lld %8lld %8lld\n",
+               title, static_cast<double>(h.sum()) / 1000.0, percentOf(h.sum(), total),
+               static_cast<long long>(h.count()),
+               static_cast<long long>(h.percentile(50)),
+               static_cast<long long>(h.percentile(99)),
+               static_cast<long long>(h.percentile(99.9)),
+               static_cast<long long>(h.max()));
+}
+
+void printLoopStats(string* out, LoopStats* stats)
+{
+  int64_t total = stats->pollMicroSeconds() + stats->channels().sum()
+      + stats->deferredMicroSeconds() + stats->pendingFunctors().sum() + stats->timers().sum();
+  stringPrintf(out, "Loop %s tid %d\n", stats->threadName().c_str(), stats->threadId());
+  stringPrintf(out, "  %-16s %10s %7s %10s %8s %8s %8s %8s\n",
+               "", "total(ms)", "share", "count", "p50(us)", "p99(us)", "p999(us)", "max(us)");
+  stringPrintf(out, "  %-16s %10.3f %6.2f%% %10lld\n", "poll",
+               static_cast<double>(stats->pollMicroSeconds()) / 1000.0,
+               percentOf(stats->pollMicroSeconds(), total),
+               static_cast<long long>(stats->polls()));
+  printHistogram(out, "channels", stats->channels(), total);
+  printHistogram(out, "timers", stats->timers(), total);
+  printHistogram(out, "pending functors", stats->pendingFunctors(), total);
+  stringPrintf(out, "  %-16s %10.3f %6.2f%%\n", "deferred",
+               static_cast<double>(stats->deferredMicroSeconds()) / 1000.0,
+               percentOf(stats->deferredMicroSeconds(), total));
+
+  const Histogram& batches = stats->pendingBatches();
+  stringPrintf(out, "  pending queue depth: p50 %lld p99 %lld max %lld\n",
+               static_cast<long long>(batches.percentile(50)),
+               static_cast<long long>(batches.percentile(99)),
+               static_cast<long long>(batches.max()));
+
+  int64_t maxMicros = stats->maxCallbackMicroSeconds();
+  switch (stats->maxCallbackKind())
+  {
+    case LoopStats::kChannel:
+      stringPrintf(out, "  slowest callback: %lld us, channel fd %d\n",
+                   static_cast<long long>(maxMicros), stats->maxCallbackFd());
+      break;
+    case LoopStats::kDeferred:
+      stringPrintf(out, "  slowest callback: %lld us, deferred functors\n",
+                   static_cast<long long>(maxMicros));
+      break;
+    case LoopStats::kPendingFunctor:
+      stringPrintf(out, "  slowest callback: %lld us, pending functor %s\n",
+                   static_cast<long long>(maxMicros), demangle(stats->maxCallbackName()).c_str());
+      break;
+    case LoopStats::kTimer:
+      stringPrintf(out, "  slowest callback: %lld us, timer %s\n",
+                   static_cast<long long>(maxMicros), demangle(stats->maxCallbackName()).c_str());
+      break;
+    default:
+      break;
+  }
+}
+
+void printBufferPool(string* out, LoopStats* stats)
+{
+  const BufferPool* pool = stats->bufferPool();
+  if (pool == NULL)
+  {
+    return;
+  }
+  BufferPool::Stats counters;
+  pool->snapshot(&counters);
+  stringPrintf(out, "Loop %s tid %d in use %lld bytes, cached %lld bytes\n",
+               stats->threadName().c_str(), stats->threadId(),
+               static_cast<long long>(counters.inUseBytes),
+               static_cast<long long>(counters.cachedBytes));
+  stringPrintf(out, "  %-8s %12s %7s %8s %8s\n", "size", "allocations", "hits", "in use", "cached");
+  for (int c = 0; c <= BufferPool::kLargeClass; ++c)
+  {
+    int64_t allocations = counters.allocations[c];
+    if (allocations == 0)
+    {
+      continue;
+    }
+    char size[32];
+    if (c == BufferPool::kLargeClass)
+    {
+      snprintf(size, sizeof size, ">%zuk", BufferPool::classSize(c - 1) / 1024);
+    }
+    else if (BufferPool::classSize(c) < 1024)
+    {
+      snprintf(size, sizeof size, "%zu", BufferPool::classSize(c));
+    }
+    else
+    {
+      snprintf(size, sizeof size, "%zuk", BufferPool::classSize(c) / 1024);
+    }
+    stringPrintf(out, "  %-8s %12lld %6.2f%% %8lld %8lld\n",
+                 size, static_cast<long long>(allocations),
+                 percentOf(counters.hits[c], allocations),
+                 static_cast<long long>(counters.inUse[c]),
+                 static_cast<long long>(counters.cached[c]));
+  }
+}
+
+void resetOne(LoopStats* stats)
+{
+  stats->reset();
+}
+
+}
+
+void NetInspector::registerCommands(Inspector* ins)
+{
+  ins->add("net", "accept", NetInspector::accept, "print accept counters of all acceptors");
+  ins->add("loops", "stats", NetInspector::loopStats, "print latency and utilization of all event loops");
+  ins->add("loops", "reset", NetInspector::resetLoopStats, "reset stats of all event loops");
+  ins->add("loops", "buffers", NetInspector::loopBuffers, "print buffer pool usage of all event loops");
+}
+
+string NetInspector::accept(HttpRequest::Method, const Inspector::ArgList&)
+{
+  int64_t accepted = Acceptor::numAccepted();
+  int64_t wakeups = Acceptor::numWakeups();
+  string result;
+  result.reserve(1024);
+  stringPrintf(&result, "Accepted: %lld\n", static_cast<long long>(accepted));
+  stringPrintf(&result, "Shed (EMFILE): %lld\n", static_cast<long long>(Acceptor::numShed()));
+  stringPrintf(&result, "Wakeups: %lld\n", static_cast<long long>(wakeups));
+  stringPrintf(&result, "Accepted per wakeup: %.2f\n",
+               wakeups > 0 ? static_cast<double>(accepted) / static_cast<double>(wakeups) : 0.0);
+
+  result += "Batch size histogram:\n";
+  stringPrintf(&result, "  %-9s %lld\n", "0", static_cast<long long>(Acceptor::numBatches(0)));
+  for (int i = 1; i < Acceptor::kNumBatchBuckets; ++i)
+  {
+    char range[32];
+    int low = 1 << (i-1);
+    if (i == Acceptor::kNumBatchBuckets - 1)
+    {
+      snprintf(range, sizeof range, "%d+", low);
+    }
+    else if (i == 1)
+    {
+      snprintf(range, sizeof range, "%d", low);
+    }
+    else
+    {
+      snprintf(range, sizeof range, "%d-%d", low, 2*low-1);
+    }
+    stringPrintf(&result, "  %-9s %lld\n", range, static_cast<long long>(Acceptor::numBatches(i)));
+  }
+  return result;
+}
+
+string NetInspector::loopStats(HttpRequest::Method, const Inspector::ArgList&)
+{
+  string result;
+  result.reserve(4096);
+  LoopStats::forEach(boost::bind(printLoopStats, &result, _1));
+  return result;
+}
+
+string NetInspector::loopBuffers(HttpRequest::Method, const Inspector::ArgList&)
+{
+  string result;
+  result.reserve(4096);
+  LoopStats::forEach(boost::bind(printBufferPool, &result, _1));
+  return result;
+}
+
+string NetInspector::resetLoopStats(HttpRequest::Method, const Inspector::ArgList&)
+{
+  LoopStats::forEach(resetOne);
+  return "OK\n";
+}
@@ -0,0 +1,36 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_NETINSPECTOR_H
+#define MUDUO_NET_INSPECT_NETINSPECTOR_H
+
+#include <muduo/net/inspect/Inspector.h>
+
+namespace muduo
+{
+namespace net
+{
+
+//网络库内部计数的监控器
+class NetInspector : boost::noncopyable
+{
+ public:
+  void registerCommands(Inspector* ins);
+
+  static string accept(HttpRequest::Method, const Inspector::ArgList&);
+  static string loopStats(HttpRequest::Method, const Inspector::ArgList&);
+  static string resetLoopStats(HttpRequest::Method, const Inspector::ArgList&);
+  static string loopBuffers(HttpRequest::Method, const Inspector::ArgList&);
+};
+
+}
+}
+
+#endif  // MUDUO_NET_INSPECT_NETINSPECTOR_H
@@ -9,6 +9,10 @@
 #include <muduo/net/Poller.h>
 #include <muduo/net/poller/PollPoller.h>
 #include <muduo/net/poller/EPollPoller.h>
+#ifndef NO_IO_URING
+#include <muduo/net/poller/IoUringPoller.h>
+#endif
+#include <muduo/base/Logging.h>
 
 #include <stdlib.h>
 
@@ -21,6 +25,19 @@ Poller* Poller::newDefaultPoller(EventLoop* loop)
   {
     return new PollPoller(loop);
   }
+  else if (::getenv("MUDUO_USE_IO_URING"))  //设置了MUDUO_USE_IO_URING则用io_uring
+  {
+#ifndef NO_IO_URING
+    if (IoUringPoller::isSupported())
+    {
+      return new IoUringPoller(loop);
+    }
+    LOG_WARN << "io_uring with IORING_FEAT_EXT_ARG is not supported by the kernel, use epoll";
+#else
+    LOG_WARN << "built without io_uring, use epoll";
+#endif
+    return new EPollPoller(loop);
+  }
   else
   {
     return new EPollPoller(loop);
@@ -13,6 +13,8 @@
 
 #include <boost/static_assert.hpp>
 
+#include <algorithm>
+
 #include <assert.h>
 #include <errno.h>
 #include <poll.h>
@@ -56,6 +58,7 @@ EPollPoller::~EPollPoller()
 //使用epoll_wait等待事件到来，并把到来的事件填充至activeChannels
 Timestamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels)
 {
+  syncDirtyChannels();
   LOG_TRACE << "fd total count " << channels_.size();
   int numEvents = ::epoll_wait(epollfd_,
                                &*events_.begin(),
@@ -98,9 +101,7 @@ void EPollPoller::fillActiveChannels(int numEvents,
     Channel* channel = static_cast<Channel*>(events_[i].data.ptr); //转换成Channel*类型
 #ifndef NDEBUG                   //如果是调试状态，则
     int fd = channel->fd();
-    ChannelMap::const_iterator it = channels_.find(fd);
-    assert(it != channels_.end());
-    assert(it->second == channel);
+    assert(channels_.find(fd) == channel);
 #endif
     channel->set_revents(events_[i].events);  //填充已发生的事件
     activeChannels->push_back(channel);  //把该channel添加进当前通道活动列表activeChannels
@@ -137,17 +138,16 @@ void EPollPoller::updateChannel(Channel* channel)
     int fd = channel->fd();
     if (index == kNew)  //新通道
     {
-      assert(channels_.find(fd) == channels_.end()); //断言如果是新的channel，那么在channels_里面是找不到的
-      channels_[fd] = channel;  //则把该新channel加入channels_
+      assert(channels_.find(fd) == NULL); //断言如果是新的channel，那么在channels_里面是找不到的
+      channels_.add(fd, channel);  //则把该新channel加入channels_
     }
     else // index == kDeleted   
     {
-      assert(channels_.find(fd) != channels_.end());
-      assert(channels_[fd] == channel);
+      assert(channels_.find(fd) == channel);
     }
 
     channel->set_index(kAdded); //设置状态为已关注
-    update(EPOLL_CTL_ADD, channel);  //把该channel对应的事件关注到epollfd_中
+    markDirty(channel);  //poll()之前再把该channel对应的事件关注到epollfd_中
   }
   //如果是已经存在的关注的通道
   else
@@ -155,18 +155,14 @@ void EPollPoller::updateChannel(Channel* channel)
     // update existing one with EPOLL_CTL_MOD/DEL
     int fd = channel->fd();
     (void)fd;
-    assert(channels_.find(fd) != channels_.end());
-    assert(channels_[fd] == channel);  //断言已经在channels_里面了，并且已在epollfd_中
+    assert(channels_.find(fd) == channel);  //断言已经在channels_里面了，并且已在epollfd_中
     assert(index == kAdded);
     if (channel->isNoneEvent())    //如果channel没有事件关注了，就把他从epollfd_中剔除掉，并更新index
     {
-      update(EPOLL_CTL_DEL, channel); //使用EPOLL_CTL_DEL从内核事件表中删除
       channel->set_index(kDeleted);  //删除之后设为deleted，表示已经删除，只是从内核事件表中删除，在channels_这个通道数组中并没有删除
     }
-    else  //如果仍然有关注，那就只是改变状态。更新成什么样子channel中会决定。
-    {
-      update(EPOLL_CTL_MOD, channel); 
-    }
+    //如果仍然有关注，那就只是改变状态。更新成什么样子channel中会决定。
+    markDirty(channel);  //poll()之前用EPOLL_CTL_MOD/DEL提交
   }
 }
 
@@ -176,8 +172,7 @@ void EPollPoller::removeChannel(Channel* channel)
   Poller::assertInLoopThread();
   int fd = channel->fd();
   LOG_TRACE << "fd = " << fd;
-  assert(channels_.find(fd) != channels_.end()); //断言能在channels_里面找到channel
-  assert(channels_[fd] == channel);
+  assert(channels_.find(fd) == channel); //断言能在channels_里面找到channel
   assert(channel->isNoneEvent()); //断言所要移除的channel已经没有事件关注了，但是此时在event_里面可能还有他的记录
   int index = channel->index();
   assert(index == kAdded || index == kDeleted);
@@ -185,13 +180,91 @@ void EPollPoller::removeChannel(Channel* channel)
   (void)n;
   assert(n == 1);
 
-  if (index == kAdded)  //如果还在关注中，则从epollfd_中删除channel对应的fd
+  //channel马上要析构，fd也可能马上被关闭，不能推迟
+  FdState& state = fdState(fd);
+  if (state.dirty)
+  {
+    ChannelList::iterator it = std::find(dirtyChannels_.begin(), dirtyChannels_.end(), channel);
+    assert(it != dirtyChannels_.end());
+    *it = dirtyChannels_.back();
+    dirtyChannels_.pop_back();
+    state.dirty = false;
+  }
+  if (state.events != kNotInEpoll)  //如果还在内核中，则从epollfd_中删除channel对应的fd
   {
     update(EPOLL_CTL_DEL, channel); 
+    state.events = kNotInEpoll;
   }
+  releaseFdState(fd);
   channel->set_index(kNew);  // 被从channels移除了，所以channel状态现在变成新的了
 }
 
+const int EPollPoller::kNotInEpoll;
+
+EPollPoller::FdState& EPollPoller::fdState(int fd)
+{
+  assert(fd >= 0);
+  if (fd >= kMaxFdTableSize)
+  {
+    return largeFdStates_[fd];
+  }
+  if (implicit_cast<size_t>(fd) >= fdStates_.size())
+  {
+    size_t newSize = std::max(implicit_cast<size_t>(fd) + 1, fdStates_.size() * 2);
+    fdStates_.resize(std::min(newSize, implicit_cast<size_t>(kMaxFdTableSize)));
+  }
+  return fdStates_[fd];
+}
+
+void EPollPoller::releaseFdState(int fd)
+{
+  if (fd >= kMaxFdTableSize)
+  {
+    assert(largeFdStates_[fd].events == kNotInEpoll && !largeFdStates_[fd].dirty);
+    largeFdStates_.erase(fd);
+  }
+}
+
+void EPollPoller::markDirty(Channel* channel)
+{
+  FdState& state = fdState(channel->fd());
+  if (!state.dirty)
+  {
+    state.dirty = true;
+    dirtyChannels_.push_back(channel);
+  }
+}
+
+void EPollPoller::syncDirtyChannels()
+{
+  for (size_t i = 0; i < dirtyChannels_.size(); ++i)
+  {
+    Channel* channel = dirtyChannels_[i];
+    FdState& state = fdState(channel->fd());
+    assert(state.dirty);
+    state.dirty = false;
+    int events = channel->index() == kAdded ? channel->events() : kNotInEpoll;
+    if (events == state.events)
+    {
+      continue;  //这一轮里改了又改回来了
+    }
+    if (state.events == kNotInEpoll)
+    {
+      update(EPOLL_CTL_ADD, channel);
+    }
+    else if (events == kNotInEpoll)
+    {
+      update(EPOLL_CTL_DEL, channel);
+    }
+    else
+    {
+      update(EPOLL_CTL_MOD, channel);
+    }
+    state.events = events;
+  }
+  dirtyChannels_.clear();
+}
+
 //epoll_ctl函数的封装。在epollfd_中更新channel对应的fd事件
 void EPollPoller::update(int operation, Channel* channel)
 {
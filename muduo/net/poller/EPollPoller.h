@@ -13,6 +13,7 @@
 
 #include <muduo/net/Poller.h>
 
+#include <map>
 #include <vector>
 
 struct epoll_event;
@@ -25,6 +26,9 @@ namespace net
 ///
 /// IO Multiplexing with epoll(4).
 ///
+/// updateChannel() only marks the channel dirty, the changes are sent
+/// to the kernel once before the next epoll_wait(), so enabling then
+/// disabling writing in one iteration costs no epoll_ctl(2) at all.
 class EPollPoller : public Poller     //注意，这里时继承了Poller类
 {
  public:
@@ -34,6 +38,7 @@ class EPollPoller : public Poller     //注意，这里时继承了Poller类
   virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels);  // 进行poll操作，timeoutMs 超时时间，activeChannels活动通道
   virtual void updateChannel(Channel* channel);  //更新通道
   virtual void removeChannel(Channel* channel);  //移除通道
+  virtual bool supportsEdgeTriggered() const { return true; }
 
  private:
   static const int kInitEventListSize = 16;  // EventList的初始空间大小 
@@ -45,11 +50,28 @@ class EPollPoller : public Poller     //注意，这里时继承了Poller类
                           ChannelList* activeChannels) const;
   //epoll_ctl函数的封装。在epollfd_中更新channel对应的fd事件
   void update(int operation, Channel* channel);
+  void markDirty(Channel* channel);
+  //把这一轮积累的修改提交给内核，和内核中已登记的事件相同的跳过
+  void syncDirtyChannels();
+
+  // 每个fd在内核中的登记状态，和channels_一样，小的fd以fd为下标，特别大的放进map
+  struct FdState
+  {
+    FdState() : events(kNotInEpoll), dirty(false) {}
+    int events;  //已经用epoll_ctl登记的事件
+    bool dirty;  //在dirtyChannels_中
+  };
+  static const int kNotInEpoll = -1;
+  FdState& fdState(int fd);
+  void releaseFdState(int fd);  //回到初始状态的大fd从map中删掉
 
   typedef std::vector<struct epoll_event> EventList;
 
   int epollfd_;  //epoll描述符
   EventList events_;  // epoll_wait返回的活动的通道channelList
+  std::vector<FdState> fdStates_;
+  std::map<int, FdState> largeFdStates_;  //fd >= kMaxFdTableSize
+  ChannelList dirtyChannels_;  //本轮修改过的channel，poll()之前统一提交
 };
 
 }
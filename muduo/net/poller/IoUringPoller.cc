@@ -0,0 +1,401 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/poller/IoUringPoller.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/Channel.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+//没有用liburing，直接用系统调用，与内核共享的ring用mmap映射
+namespace
+{
+const int kNew = -1;
+const int kAdded = 1;
+const int kDeleted = 2;
+
+// user_data为0的CQE是撤销请求本身的完成通知，直接忽略
+const uint64_t kIgnoredToken = 0;
+
+int io_uring_setup(unsigned entries, struct io_uring_params* params)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(int ringfd, unsigned toSubmit, unsigned minComplete,
+                   unsigned flags, void* arg, size_t argSize)
+{
+  return static_cast<int>(::syscall(__NR_io_uring_enter, ringfd, toSubmit,
+                                    minComplete, flags, arg, argSize));
+}
+
+//与内核共享的head/tail需要内存屏障
+unsigned loadAcquire(const unsigned* p)
+{
+  unsigned v = *static_cast<const volatile unsigned*>(p);
+  __sync_synchronize();
+  return v;
+}
+
+void storeRelease(unsigned* p, unsigned v)
+{
+  __sync_synchronize();
+  *static_cast<volatile unsigned*>(p) = v;
+}
+
+void* offsetOf(void* base, unsigned offset)
+{
+  return static_cast<char*>(base) + offset;
+}
+
+//token的低32位是fd，高32位是序号，fd关闭后被复用也不会认错
+int tokenToFd(uint64_t token)
+{
+  return static_cast<int>(token & 0xffffffff);
+}
+
+//建一个最小的ring看内核支不支持
+bool probeIoUring()
+{
+  struct io_uring_params params;
+  bzero(&params, sizeof params);
+  int fd = io_uring_setup(1, &params);
+  if (fd < 0)
+  {
+    return false;
+  }
+  ::close(fd);
+  return (params.features & IORING_FEAT_EXT_ARG) != 0;
+}
+}
+
+bool IoUringPoller::isSupported()
+{
+  static const bool supported = probeIoUring();
+  return supported;
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+  : Poller(loop),
+    ringfd_(-1),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+    sqesSize_(0),
+    sqHead_(NULL),
+    sqTail_(NULL),
+    sqArray_(NULL),
+    sqMask_(0),
+    sqEntries_(0),
+    cqHead_(NULL),
+    cqTail_(NULL),
+    cqes_(NULL),
+    cqMask_(0),
+    toSubmit_(0),
+    sequence_(0)
+{
+  struct io_uring_params params;
+  bzero(&params, sizeof params);
+  ringfd_ = io_uring_setup(kRingEntries, &params);
+  if (ringfd_ < 0)
+  {
+    LOG_SYSFATAL << "IoUringPoller::IoUringPoller";
+  }
+  if (!(params.features & IORING_FEAT_EXT_ARG))
+  {
+    LOG_FATAL << "IoUringPoller::IoUringPoller - IORING_FEAT_EXT_ARG not supported";
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = ::mmap(NULL, sqRingSize_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+  if (sqRing_ == MAP_FAILED)
+  {
+    LOG_SYSFATAL << "IoUringPoller::IoUringPoller - mmap sq ring";
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+  {
+    cqRing_ = sqRing_;
+  }
+  else
+  {
+    cqRing_ = ::mmap(NULL, cqRingSize_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+    if (cqRing_ == MAP_FAILED)
+    {
+      LOG_SYSFATAL << "IoUringPoller::IoUringPoller - mmap cq ring";
+    }
+  }
+  sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(
+      ::mmap(NULL, sqesSize_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ringfd_, IORING_OFF_SQES));
+  if (sqes_ == MAP_FAILED)
+  {
+    LOG_SYSFATAL << "IoUringPoller::IoUringPoller - mmap sqes";
+  }
+
+  sqHead_ = static_cast<unsigned*>(offsetOf(sqRing_, params.sq_off.head));
+  sqTail_ = static_cast<unsigned*>(offsetOf(sqRing_, params.sq_off.tail));
+  sqArray_ = static_cast<unsigned*>(offsetOf(sqRing_, params.sq_off.array));
+  sqMask_ = *static_cast<unsigned*>(offsetOf(sqRing_, params.sq_off.ring_mask));
+  sqEntries_ = params.sq_entries;
+  cqHead_ = static_cast<unsigned*>(offsetOf(cqRing_, params.cq_off.head));
+  cqTail_ = static_cast<unsigned*>(offsetOf(cqRing_, params.cq_off.tail));
+  cqes_ = static_cast<io_uring_cqe*>(offsetOf(cqRing_, params.cq_off.cqes));
+  cqMask_ = *static_cast<unsigned*>(offsetOf(cqRing_, params.cq_off.ring_mask));
+
+  // SQ的索引数组固定为一一对应，之后只需移动tail
+  for (unsigned i = 0; i < sqEntries_; ++i)
+  {
+    sqArray_[i] = i;
+  }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+  ::munmap(sqes_, sqesSize_);
+  if (cqRing_ != sqRing_)
+  {
+    ::munmap(cqRing_, cqRingSize_);
+  }
+  ::munmap(sqRing_, sqRingSize_);
+  ::close(ringfd_);
+}
+
+//提交积攒的SQE并等待至少一个完成事件，一共一次系统调用
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+  LOG_TRACE << "fd total count " << channels_.size();
+  rearmPolls();
+
+  struct __kernel_timespec ts;
+  ts.tv_sec = timeoutMs / 1000;
+  ts.tv_nsec = (timeoutMs % 1000) * 1000 * 1000;
+  struct io_uring_getevents_arg arg;
+  bzero(&arg, sizeof arg);
+  if (timeoutMs >= 0)
+  {
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+  }
+  int ret = io_uring_enter(ringfd_, toSubmit_, 1,
+                           IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg, sizeof arg);
+  int savedErrno = errno;
+  Timestamp now(Timestamp::now());
+  if (ret >= 0)
+  {
+    assert(static_cast<unsigned>(ret) <= toSubmit_);
+    toSubmit_ -= ret;
+  }
+  else if (savedErrno != EINTR && savedErrno != ETIME)
+  {
+    errno = savedErrno;
+    LOG_SYSERR << "IoUringPoller::poll()";
+  }
+
+  size_t numEvents = activeChannels->size();
+  fillActiveChannels(activeChannels);
+  numEvents = activeChannels->size() - numEvents;
+  if (numEvents > 0)
+  {
+    LOG_TRACE << numEvents << " events happended";
+  }
+  else
+  {
+    LOG_TRACE << "nothing happended";
+  }
+  return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+  unsigned head = *cqHead_;
+  const unsigned tail = loadAcquire(cqTail_);
+  for (; head != tail; ++head)
+  {
+    const struct io_uring_cqe& cqe = cqes_[head & cqMask_];
+    const uint64_t token = cqe.user_data;
+    if (token == kIgnoredToken)
+    {
+      continue;
+    }
+    int fd = tokenToFd(token);
+    TokenMap::iterator it = tokens_.find(fd);
+    if (it == tokens_.end() || it->second != token)
+    {
+      continue;  //已被撤销或替换的poll请求
+    }
+    Channel* channel = channels_.find(fd);
+    assert(channel != NULL);
+    if (cqe.res < 0)
+    {
+      errno = -cqe.res;
+      LOG_SYSERR << "IoUringPoller::fillActiveChannels fd = " << fd;
+      channel->set_revents(POLLNVAL);
+    }
+    else
+    {
+      channel->set_revents(cqe.res);
+    }
+    activeChannels->push_back(channel);
+    rearms_.push_back(std::make_pair(fd, token));  // poll请求是一次性的
+  }
+  storeRelease(cqHead_, head);
+}
+
+//单次的poll请求在提交时会检查当前状态，效果与epoll的水平触发一样：
+//回调里没读完的数据，下一轮还会报告
+void IoUringPoller::rearmPolls()
+{
+  for (TokenList::const_iterator it = rearms_.begin();
+       it != rearms_.end(); ++it)
+  {
+    TokenMap::const_iterator token = tokens_.find(it->first);
+    if (token != tokens_.end() && token->second == it->second)
+    {
+      io_uring_sqe* sqe = getSqe();
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = it->first;
+      sqe->poll32_events = channels_.find(it->first)->events();
+      sqe->user_data = it->second;
+    }
+  }
+  rearms_.clear();
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  const int index = channel->index();
+  LOG_TRACE << "fd = " << channel->fd()
+    << " events = " << channel->events() << " index = " << index;
+  if (index == kNew || index == kDeleted)
+  {
+    int fd = channel->fd();
+    if (index == kNew)
+    {
+      assert(channels_.find(fd) == NULL);
+      channels_.add(fd, channel);
+    }
+    else // index == kDeleted
+    {
+      assert(channels_.find(fd) == channel);
+    }
+    channel->set_index(kAdded);
+    armPoll(channel);
+  }
+  else
+  {
+    int fd = channel->fd();
+    assert(channels_.find(fd) == channel);
+    assert(index == kAdded);
+    cancelPoll(fd);
+    if (channel->isNoneEvent())
+    {
+      channel->set_index(kDeleted);
+    }
+    else
+    {
+      armPoll(channel);  //撤销旧请求，按新的events再提交一个
+    }
+  }
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+  Poller::assertInLoopThread();
+  int fd = channel->fd();
+  LOG_TRACE << "fd = " << fd;
+  assert(channels_.find(fd) == channel);
+  assert(channel->isNoneEvent());
+  int index = channel->index();
+  assert(index == kAdded || index == kDeleted);
+  size_t n = channels_.erase(fd);
+  (void)n;
+  assert(n == 1);
+
+  if (index == kAdded)
+  {
+    cancelPoll(fd);
+  }
+  channel->set_index(kNew);
+}
+
+io_uring_sqe* IoUringPoller::getSqe()
+{
+  unsigned tail = *sqTail_;
+  if (tail - loadAcquire(sqHead_) == sqEntries_)
+  {
+    //提交队列满了，先提交一批，不等待完成事件
+    int ret = io_uring_enter(ringfd_, toSubmit_, 0, 0, NULL, 0);
+    if (ret < 0)
+    {
+      LOG_SYSFATAL << "IoUringPoller::getSqe";
+    }
+    toSubmit_ -= ret;
+  }
+  io_uring_sqe* sqe = &sqes_[tail & sqMask_];
+  bzero(sqe, sizeof *sqe);
+  storeRelease(sqTail_, tail + 1);
+  ++toSubmit_;
+  return sqe;
+}
+
+void IoUringPoller::armPoll(Channel* channel)
+{
+  const int fd = channel->fd();
+  ++sequence_;
+  if (sequence_ == 0)
+  {
+    ++sequence_;  //保证token不为kIgnoredToken
+  }
+  const uint64_t token = (static_cast<uint64_t>(sequence_) << 32)
+                         | static_cast<uint32_t>(fd);
+  tokens_[fd] = token;
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = channel->events();
+  sqe->user_data = token;
+  LOG_TRACE << "poll add fd = " << fd << " event = { "
+            << channel->eventsToString() << " }";
+}
+
+void IoUringPoller::cancelPoll(int fd)
+{
+  TokenMap::iterator it = tokens_.find(fd);
+  assert(it != tokens_.end());
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = it->second;
+  sqe->user_data = kIgnoredToken;
+  tokens_.erase(it);  //之后收到这个token的CQE都会被忽略
+  LOG_TRACE << "poll remove fd = " << fd;
+}
@@ -0,0 +1,90 @@
+// Copyright 2010, Shuo Chen.  All rights reserved.
+// http://code.google.com/p/muduo/
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include <muduo/net/Poller.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace muduo
+{
+namespace net
+{
+
+///
+/// IO Multiplexing with io_uring(7) poll requests.
+///
+/// 注册、修改、删除通道只是往提交队列里放一个SQE，不立即进入内核，
+/// 积攒到下一次poll()时和等待事件一起由一次io_uring_enter(2)完成，
+/// 省去了EPollPoller中每次epoll_ctl(2)的系统调用。
+/// 需要Linux 5.11以上(IORING_FEAT_EXT_ARG)。
+class IoUringPoller : public Poller
+{
+ public:
+  IoUringPoller(EventLoop* loop);
+  virtual ~IoUringPoller();
+
+  /// Whether the kernel has io_uring with IORING_FEAT_EXT_ARG (Linux 5.11),
+  /// probed once, io_uring may also be disabled by seccomp or sysctl.
+  static bool isSupported();
+
+  virtual Timestamp poll(int timeoutMs, ChannelList* activeChannels);
+  virtual void updateChannel(Channel* channel);
+  virtual void removeChannel(Channel* channel);
+
+ private:
+  static const unsigned kRingEntries = 1024;  //提交队列的大小
+
+  io_uring_sqe* getSqe();  //取一个空闲SQE，队列满了就先提交
+  void armPoll(Channel* channel);  //为channel提交一个新的poll请求
+  void cancelPoll(int fd);  //撤销fd当前的poll请求
+  void rearmPolls();  //上一轮返回了事件的通道重新提交poll请求
+  //把CQ中已完成的poll请求填充给活跃事件通道表activeChannels
+  void fillActiveChannels(ChannelList* activeChannels);
+
+  typedef std::map<int, uint64_t> TokenMap;
+  typedef std::vector<std::pair<int, uint64_t> > TokenList;
+
+  int ringfd_;
+  void* sqRing_;  // mmap的SQ ring
+  size_t sqRingSize_;
+  void* cqRing_;  // mmap的CQ ring，内核支持IORING_FEAT_SINGLE_MMAP时与sqRing_相同
+  size_t cqRingSize_;
+  io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned* sqArray_;
+  unsigned sqMask_;
+  unsigned sqEntries_;
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  io_uring_cqe* cqes_;
+  unsigned cqMask_;
+
+  unsigned toSubmit_;  //已放入SQ但还没提交给内核的SQE数目
+  uint32_t sequence_;  //每提交一个poll请求加一，用于生成token
+  TokenMap tokens_;  // fd -> 当前有效的poll请求的user_data
+  TokenList rearms_;  //poll请求已完成，等待重新提交的(fd, token)
+};
+
+}
+}
+#endif  // MUDUO_NET_POLLER_IOURINGPOLLER_H
@@ -63,9 +63,8 @@ void PollPoller::fillActiveChannels(int numEvents,
     if (pfd->revents > 0)
     {
       --numEvents;   //为了提前结束循环，每找到一个fd就递减numEvents
-      ChannelMap::const_iterator ch = channels_.find(pfd->fd);
-      assert(ch != channels_.end());
-      Channel* channel = ch->second;
+      Channel* channel = channels_.find(pfd->fd);
+      assert(channel != NULL);
       assert(channel->fd() == pfd->fd);   //map<int,Channel*>，把fd与Channel对应起来
       channel->set_revents(pfd->revents);  //赋值channel的revents事件
       // pfd->revents = 0;
@@ -81,21 +80,24 @@ void PollPoller::updateChannel(Channel* channel)    //负责维护和更新pollf
   if (channel->index() < 0)    //在Channel构造函数被初始化为-1，小于0表示是一个新通道
   {
     // a new one, add to pollfds_   //在Channel_数组（std::map<int, Channel*>）中不存在
-    assert(channels_.find(channel->fd()) == channels_.end());
+    assert(channels_.find(channel->fd()) == NULL);
     struct pollfd pfd;
     pfd.fd = channel->fd();
     pfd.events = static_cast<short>(channel->events());
     pfd.revents = 0;
+    if (channel->isNoneEvent())  //例如没有listen过的Acceptor析构时disableAll()，同样让poll忽略此项
+    {
+      pfd.fd = -channel->fd()-1;
+    }
     pollfds_.push_back(pfd);  //加入到容器中最后一个位置
     int idx = static_cast<int>(pollfds_.size())-1;
     channel->set_index(idx);   //并设置数组序号
-    channels_[pfd.fd] = channel;  //在第fd处存储该channel（即实现映射map关系）
+    channels_.add(channel->fd(), channel);  //在第fd处存储该channel（即实现映射map关系）
   }
   else    //表示已有的通道
   {
     // update existing one
-    assert(channels_.find(channel->fd()) != channels_.end());  //能在Channels_中找到该Channel
-    assert(channels_[channel->fd()] == channel);
+    assert(channels_.find(channel->fd()) == channel);  //能在Channels_中找到该Channel
     int idx = channel->index();
     assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
     struct pollfd& pfd = pollfds_[idx];
@@ -115,8 +117,7 @@ void PollPoller::removeChannel(Channel* channel)
 {
   Poller::assertInLoopThread();
   LOG_TRACE << "fd = " << channel->fd();
-  assert(channels_.find(channel->fd()) != channels_.end());
-  assert(channels_[channel->fd()] == channel);
+  assert(channels_.find(channel->fd()) == channel);
   assert(channel->isNoneEvent());
   int idx = channel->index();
   assert(0 <= idx && idx < static_cast<int>(pollfds_.size()));
@@ -137,7 +138,7 @@ void PollPoller::removeChannel(Channel* channel)
     {
       channelAtEnd = -channelAtEnd-1;
     }
-    channels_[channelAtEnd]->set_index(idx);//因为交换了位置，所以index发生了变化
+    channels_.find(channelAtEnd)->set_index(idx);//因为交换了位置，所以index发生了变化
     pollfds_.pop_back();
   }
 }
@@ -10,11 +10,13 @@ project "net"
         'Buffer.h',
         'Callbacks.h',
         'Channel.h',
+        'ContextSlots.h',
         'Endian.h',
         'EventLoop.h',
         'EventLoopThread.h',
         'EventLoopThreadPool.h',
         'InetAddress.h',
+        'LoopWatchdog.h',
         'TcpClient.h',
         'TcpConnection.h',
         'TcpServer.h',
@@ -24,15 +26,20 @@ project "net"
     files {
         'Acceptor.cc',
         'Buffer.cc',
+        'BufferChain.cc',
         'Channel.cc',
         'Connector.cc',
         'EventLoop.cc',
         'EventLoopThread.cc',
         'EventLoopThreadPool.cc',
+        'IdleConnectionList.cc',
         'InetAddress.cc',
+        'LoopStats.cc',
+        'LoopWatchdog.cc',
         'Poller.cc',
         'poller/DefaultPoller.cc',
         'poller/EPollPoller.cc',
+        'poller/IoUringPoller.cc',
         'poller/PollPoller.cc',
         'Socket.cc',
         'SocketsOps.cc',
@@ -41,5 +48,6 @@ project "net"
         'TcpServer.cc',
         'Timer.cc',
         'TimerQueue.cc',
+        'TimingWheel.cc',
      }
 
@@ -51,11 +51,11 @@ void RpcServer::onConnection(const TcpConnectionPtr& conn)
     channel->setServices(&services_);
     conn->setMessageCallback(
         boost::bind(&RpcChannel::onMessage, get_pointer(channel), _1, _2, _3));
-    conn->setContext(channel);
+    conn->contexts().set(ContextSlots::kCodecSlot, channel);  //channel与连接同生命期
   }
   else
   {
-    conn->setContext(RpcChannelPtr());
+    conn->contexts().reset(ContextSlots::kCodecSlot);
     // FIXME:
   }
 }
@@ -64,7 +64,7 @@ void RpcServer::onConnection(const TcpConnectionPtr& conn)
 //                           Buffer* buf,
 //                           Timestamp time)
 // {
-//   RpcChannelPtr& channel = boost::any_cast<RpcChannelPtr&>(conn->getContext());
-//   channel->onMessage(conn, buf, time);
+//   RpcChannelPtr* channel = conn->contexts().get<RpcChannelPtr>(ContextSlots::kCodecSlot);
+//   (*channel)->onMessage(conn, buf, time);
 // }
 
@@ -0,0 +1,155 @@
+#include <muduo/net/BufferChain.h>
+
+//#define BOOST_TEST_MODULE BufferChainTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using muduo::string;
+using muduo::net::BufferChain;
+
+BOOST_AUTO_TEST_CASE(testBufferChainAppendRetrieve)
+{
+  BufferChain chain;
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 0);
+
+  const string str(200, 'x');
+  chain.append(str);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), str.size());
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 1);
+
+  chain.retrieve(50);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 150);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 1);
+
+  chain.retrieve(150);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainGrow)
+{
+  BufferChain chain;
+  const size_t len = BufferChain::kBlockSize * 2 + 100;
+  string str;
+  for (size_t i = 0; i < len; ++i)
+  {
+    str.push_back(static_cast<char>('a' + i % 26));
+  }
+  chain.append(str);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), len);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 3);
+
+  chain.append(str);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 2*len);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 5);
+
+  chain.retrieve(BufferChain::kBlockSize + 1);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 2*len - BufferChain::kBlockSize - 1);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 4);
+
+  const string all = chain.retrieveAllAsString();
+  BOOST_CHECK_EQUAL(all, (str + str).substr(BufferChain::kBlockSize + 1));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainWriteFd)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::pipe(fds), 0);
+
+  BufferChain chain;
+  const string str(BufferChain::kBlockSize + 1000, 'w');
+  chain.append(str);
+  chain.append("hello", 5);
+
+  int savedErrno = 0;
+  ssize_t n = chain.writeFd(fds[1], &savedErrno);
+  BOOST_CHECK_EQUAL(n, static_cast<ssize_t>(str.size() + 5));
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 0);
+
+  string received(str.size() + 5, '\0');
+  size_t nread = 0;
+  while (nread < received.size())
+  {
+    ssize_t nr = ::read(fds[0], &received[nread], received.size() - nread);
+    BOOST_REQUIRE(nr > 0);
+    nread += nr;
+  }
+  BOOST_CHECK_EQUAL(received, str + "hello");
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainSharedMessage)
+{
+  muduo::net::SharedStringPtr message(new string(1000, 'm'));
+  {
+    BufferChain chain;
+    chain.append("head", 4);
+    chain.append(message);
+    chain.append(message, 990);
+    chain.append("tail", 4);
+    BOOST_CHECK_EQUAL(chain.readableBytes(), 4 + 1000 + 10 + 4);
+    BOOST_CHECK_EQUAL(chain.numBlocks(), 4);
+    BOOST_CHECK_EQUAL(message.use_count(), 3);
+
+    chain.retrieve(4 + 1000);
+    BOOST_CHECK_EQUAL(message.use_count(), 2);
+    BOOST_CHECK_EQUAL(chain.retrieveAllAsString(), string(10, 'm') + "tail");
+    BOOST_CHECK_EQUAL(message.use_count(), 1);
+
+    chain.append(message);
+  }
+  BOOST_CHECK_EQUAL(message.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferChainFile)
+{
+  char path[] = "/tmp/bufferchain_unittest_XXXXXX";
+  int filefd = ::mkstemp(path);
+  BOOST_REQUIRE(filefd >= 0);
+  ::unlink(path);
+  const string content("0123456789abcdefghij");
+  BOOST_REQUIRE_EQUAL(::write(filefd, content.data(), content.size()),
+                      static_cast<ssize_t>(content.size()));
+
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+  BufferChain chain;
+  chain.append("head", 4);
+  chain.appendFile(filefd, 5, 10);
+  chain.append("tail", 4);
+  BOOST_CHECK_EQUAL(chain.readableBytes(), 18);
+
+  int savedErrno = 0;
+  while (chain.readableBytes() > 0)
+  {
+    BOOST_REQUIRE(chain.writeFd(fds[0], &savedErrno) > 0);
+  }
+  BOOST_CHECK_EQUAL(chain.numBlocks(), 0);
+  BOOST_CHECK(::fcntl(filefd, F_GETFD) < 0);  // closed by chain
+
+  char buf[64];
+  size_t nread = 0;
+  while (nread < 18)
+  {
+    ssize_t nr = ::read(fds[1], buf + nread, sizeof buf - nread);
+    BOOST_REQUIRE(nr > 0);
+    nread += nr;
+  }
+  BOOST_CHECK_EQUAL(string(buf, nread), "head56789abcdetail");
+
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
@@ -0,0 +1,200 @@
+#include <muduo/net/BufferPool.h>
+#include <muduo/net/Buffer.h>
+
+//#define BOOST_TEST_MODULE BufferPoolTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using muduo::string;
+using muduo::net::Buffer;
+using muduo::net::BufferPool;
+
+BOOST_AUTO_TEST_CASE(testBufferPoolSizeClass)
+{
+  BOOST_CHECK_EQUAL(BufferPool::classOf(1), 0);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(256), 0);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(257), 1);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(512), 1);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(Buffer::kCheapPrepend + Buffer::kInitialSize), 3);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(1024*1024), BufferPool::kNumClasses - 1);
+  BOOST_CHECK_EQUAL(BufferPool::classOf(1024*1024+1), BufferPool::kLargeClass);
+  BOOST_CHECK_EQUAL(BufferPool::classSize(3), 2048);
+  BOOST_CHECK_EQUAL(BufferPool::maxCachedBlocks(0), 4096);
+  BOOST_CHECK_EQUAL(BufferPool::maxCachedBlocks(BufferPool::kNumClasses - 1), BufferPool::kMinCachedBlocks);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolReuse)
+{
+  BufferPool pool;
+  size_t size = 1000;
+  char* p = pool.allocate(&size);
+  BOOST_CHECK_EQUAL(size, 1024);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 1024);
+  pool.deallocate(p, size);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+  BOOST_CHECK_EQUAL(pool.cached(2), 1);
+  BOOST_CHECK_EQUAL(pool.cachedBytes(), 1024);
+
+  size = 600;
+  char* q = pool.allocate(&size);
+  BOOST_CHECK_EQUAL(q, p);
+  BOOST_CHECK_EQUAL(pool.allocations(2), 2);
+  BOOST_CHECK_EQUAL(pool.hits(2), 1);
+  BOOST_CHECK_EQUAL(pool.cached(2), 0);
+  pool.deallocate(q, size);
+
+  size = 2*1024*1024;
+  char* large = pool.allocate(&size);
+  BOOST_CHECK_EQUAL(size, 2*1024*1024);
+  BOOST_CHECK_EQUAL(pool.inUse(BufferPool::kLargeClass), 1);
+  pool.deallocate(large, size);
+  BOOST_CHECK_EQUAL(pool.inUse(BufferPool::kLargeClass), 0);
+  BOOST_CHECK_EQUAL(pool.cachedBytes(), 1024);
+
+  pool.trim();
+  BOOST_CHECK_EQUAL(pool.cached(2), 0);
+  BOOST_CHECK_EQUAL(pool.cachedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolCacheLimit)
+{
+  BufferPool pool;
+  const int c = BufferPool::kNumClasses - 1;
+  const int n = BufferPool::maxCachedBlocks(c) + 2;
+  std::vector<char*> blocks;
+  for (int i = 0; i < n; ++i)
+  {
+    size_t size = BufferPool::classSize(c);
+    blocks.push_back(pool.allocate(&size));
+  }
+  BOOST_CHECK_EQUAL(pool.inUse(c), n);
+  for (int i = 0; i < n; ++i)
+  {
+    pool.deallocate(blocks[i], BufferPool::classSize(c));
+  }
+  BOOST_CHECK_EQUAL(pool.inUse(c), 0);
+  BOOST_CHECK_EQUAL(pool.cached(c), BufferPool::maxCachedBlocks(c));
+}
+
+BOOST_AUTO_TEST_CASE(testBufferFromPool)
+{
+  BufferPool pool;
+  {
+    Buffer buf(&pool, 0);
+    BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+
+    buf.append(string(300, 'x'));
+    BOOST_CHECK_EQUAL(buf.readableBytes(), 300);
+    BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
+    BOOST_CHECK_EQUAL(buf.internalCapacity(), 512);
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 512);
+
+    buf.retrieve(100);
+    buf.append(string(3000, 'y'));  //翻倍后向上取整
+    BOOST_CHECK_EQUAL(buf.readableBytes(), 3200);
+    BOOST_CHECK_EQUAL(buf.internalCapacity(), 4096);
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 4096);
+    BOOST_CHECK_EQUAL(pool.cached(1), 1);
+    BOOST_CHECK_EQUAL(buf.retrieveAsString(200), string(200, 'x'));
+    BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), string(3000, 'y'));
+
+    buf.append("hello");
+    buf.shrink(10);
+    BOOST_CHECK_EQUAL(buf.internalCapacity(), 2048);
+    BOOST_CHECK_EQUAL(buf.writableBytes(), Buffer::kInitialSize - 5);
+    BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), "hello");
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 2048);
+    BOOST_CHECK_EQUAL(pool.hits(3), 0);
+
+    buf.shrink(0);
+    BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+    BOOST_CHECK(buf.pool() == &pool);
+
+    buf.append("world");
+    Buffer copy(buf);
+    BOOST_CHECK(copy.pool() == NULL);
+    BOOST_CHECK_EQUAL(copy.retrieveAllAsString(), "world");
+    BOOST_CHECK_EQUAL(pool.inUseBytes(), 256);
+    BOOST_CHECK_EQUAL(pool.hits(0), 0);
+  }
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferSetPool)
+{
+  BufferPool pool;
+  Buffer buf;
+  buf.append(string(100, 'z'));
+  buf.retrieve(10);
+  buf.setPool(&pool);
+  BOOST_CHECK(buf.pool() == &pool);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 90);
+  BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend + 10);
+  BOOST_CHECK_EQUAL(buf.writableBytes(), Buffer::kInitialSize - 100);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 2048);
+
+  buf.setPool(NULL);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), string(90, 'z'));
+
+  buf.setPool(&pool);
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);  //空的直接释放
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+  buf.setPool(NULL);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferPoolDestroy)
+{
+  BufferPool* pool = new BufferPool;
+  {
+    Buffer buf(pool, 100);
+    buf.append("hello");
+    pool->destroy();  //buf析构时才真正删除
+    BOOST_CHECK_EQUAL(pool->cachedBytes(), 0);
+    buf.append(string(1000, 'x'));
+    BOOST_CHECK_EQUAL(pool->cachedBytes(), 0);
+    BOOST_CHECK_EQUAL(buf.retrieveAsString(5), "hello");
+  }
+}
+
+// 交换之后各自的内存仍然来自各自的pool
+BOOST_AUTO_TEST_CASE(testBufferSwapKeepsPool)
+{
+  BufferPool pool;
+  Buffer pooled(&pool, 0);
+  pooled.append("pooled");
+  Buffer heap;
+  heap.append(string(1000, 'h'));
+
+  pooled.swap(heap);
+  BOOST_CHECK(pooled.pool() == &pool);
+  BOOST_CHECK(heap.pool() == NULL);
+  BOOST_CHECK_EQUAL(heap.retrieveAllAsString(), "pooled");
+  BOOST_CHECK_EQUAL(pooled.readableBytes(), 1000);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 2048);
+
+  BufferPool::Stats stats;
+  pool.snapshot(&stats);
+  BOOST_CHECK_EQUAL(stats.inUseBytes, 2048);
+  BOOST_CHECK_EQUAL(stats.inUse[3], 1);
+  BOOST_CHECK_EQUAL(stats.allocations[0] + stats.allocations[3], 2);
+
+  heap.swap(pooled);  //空的那边释放内存
+  BOOST_CHECK_EQUAL(heap.readableBytes(), 1000);
+  BOOST_CHECK_EQUAL(pooled.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+
+#ifdef __GXX_EXPERIMENTAL_CXX0X__
+  pooled.append("moved");
+  Buffer moved(std::move(pooled));
+  BOOST_CHECK(moved.pool() == NULL);
+  BOOST_CHECK(pooled.pool() == &pool);
+  BOOST_CHECK_EQUAL(moved.retrieveAllAsString(), "moved");
+  BOOST_CHECK_EQUAL(pool.inUseBytes(), 0);
+#endif
+}
@@ -5,6 +5,9 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 using muduo::string;
 using muduo::net::Buffer;
 
@@ -102,6 +105,29 @@ BOOST_AUTO_TEST_CASE(testBufferShrink)
   BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
 }
 
+BOOST_AUTO_TEST_CASE(testBufferShrinkEmpty)
+{
+  Buffer buf;
+  buf.append(string(2000, 'y'));
+  buf.retrieveAll();
+  buf.shrink(0);  //空的Buffer释放全部内存
+  BOOST_CHECK_EQUAL(buf.internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 0);
+  BOOST_CHECK_EQUAL(buf.writableBytes(), 0);
+  buf.retrieveAll();
+  BOOST_CHECK_EQUAL(buf.writableBytes(), 0);
+  BOOST_CHECK(buf.findCRLF() == NULL);
+
+  buf.append("hello\r\n", 7);
+  BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 7);
+  BOOST_CHECK(buf.findCRLF() != NULL);
+  buf.prependInt32(7);
+  BOOST_CHECK_EQUAL(buf.readInt32(), 7);
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), "hello\r\n");
+  BOOST_CHECK_EQUAL(buf.prependableBytes(), Buffer::kCheapPrepend);
+}
+
 BOOST_AUTO_TEST_CASE(testBufferPrepend)
 {
   Buffer buf;
@@ -152,6 +178,48 @@ BOOST_AUTO_TEST_CASE(testBufferFindEOL)
   BOOST_CHECK_EQUAL(buf.findEOL(buf.peek()+90000), null);
 }
 
+BOOST_AUTO_TEST_CASE(testBufferFindCRLFResumable)
+{
+  Buffer buf;
+  size_t scanned = 0;
+  buf.append("GET / HTTP/1.1\r");
+  BOOST_CHECK(buf.findCRLF(&scanned) == NULL);
+  BOOST_CHECK_EQUAL(scanned, 14);  // 末尾的\r下次再看
+
+  buf.append("\nHost: a\r\n\r\n");
+  const char* crlf = buf.findCRLF(&scanned);
+  BOOST_CHECK(crlf == buf.peek() + 14);
+  BOOST_CHECK_EQUAL(scanned, 14);
+  buf.retrieveUntil(crlf + 2);
+  scanned = 0;
+
+  const char* end = buf.findDelimiter("\r\n\r\n", &scanned);
+  BOOST_CHECK(end == buf.peek() + 7);
+  BOOST_CHECK(buf.findDelimiter("\r\n\r\n") == end);
+  BOOST_CHECK(buf.findDelimiter("\n\n") == NULL);
+  BOOST_CHECK(buf.findCRLF() == buf.peek() + 7);
+}
+
+BOOST_AUTO_TEST_CASE(testBufferReadFdMaxBytes)
+{
+  int fds[2];
+  BOOST_REQUIRE_EQUAL(::pipe2(fds, O_NONBLOCK), 0);
+  BOOST_REQUIRE_GE(::fcntl(fds[1], F_SETPIPE_SZ, 65536), 20000);  // not the default capacity
+  string data(20000, 'y');
+  BOOST_REQUIRE_EQUAL(::write(fds[1], data.data(), data.size()), 20000);
+
+  Buffer buf;
+  int savedErrno = 0;
+  BOOST_CHECK_EQUAL(buf.readFd(fds[0], &savedErrno, 100), 100);  // less than writable
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 100);
+  BOOST_CHECK_EQUAL(buf.readFd(fds[0], &savedErrno, 5000), 5000);  // spills into extrabuf
+  BOOST_CHECK_EQUAL(buf.readableBytes(), 5100);
+  BOOST_CHECK_EQUAL(buf.readFd(fds[0], &savedErrno), 20000-5100);
+  BOOST_CHECK_EQUAL(buf.retrieveAllAsString(), data);
+  ::close(fds[0]);
+  ::close(fds[1]);
+}
+
 #ifdef __GXX_EXPERIMENTAL_CXX0X__
 void output(Buffer&& buf, const void* inner)
 {
@@ -0,0 +1,104 @@
+#include <muduo/net/ContextSlots.h>
+#include <muduo/base/Types.h>
+
+//#define BOOST_TEST_MODULE ContextSlotsTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+using muduo::string;
+using muduo::net::ContextSlots;
+
+namespace
+{
+
+int g_alive = 0;
+
+template<int N>
+struct Counted
+{
+  Counted() { ++g_alive; }
+  Counted(const Counted&) { ++g_alive; }
+  ~Counted() { --g_alive; }
+  char data[N];
+};
+
+typedef Counted<60> Small;
+typedef Counted<1000> Large;
+
+bool isInline(const ContextSlots& slots, const void* p)
+{
+  const char* begin = reinterpret_cast<const char*>(&slots);
+  return begin <= static_cast<const char*>(p)
+      && static_cast<const char*>(p) < begin + sizeof slots;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testContextSlotsGetSet)
+{
+  ContextSlots slots;
+  BOOST_CHECK(slots.empty(ContextSlots::kCodecSlot));
+  BOOST_CHECK(slots.get<string>(ContextSlots::kCodecSlot) == NULL);
+
+  string* s = slots.set(ContextSlots::kCodecSlot, string("codec"));
+  int* n = slots.set(ContextSlots::kUserSlot, 42);
+  BOOST_CHECK(isInline(slots, s));
+  BOOST_CHECK(isInline(slots, n));
+  BOOST_CHECK_EQUAL(*slots.get<string>(ContextSlots::kCodecSlot), "codec");
+  BOOST_CHECK_EQUAL(*slots.get<int>(ContextSlots::kUserSlot), 42);
+
+  slots.set(ContextSlots::kUserSlot, 43);
+  BOOST_CHECK_EQUAL(*slots.get<int>(ContextSlots::kUserSlot), 43);
+  slots.reset(ContextSlots::kCodecSlot);
+  BOOST_CHECK(slots.empty(ContextSlots::kCodecSlot));
+  BOOST_CHECK(!slots.empty(ContextSlots::kUserSlot));
+}
+
+BOOST_AUTO_TEST_CASE(testContextSlotsDestroy)
+{
+  {
+    ContextSlots slots;
+    Small* small = slots.set(0, Small());
+    Large* large = slots.set(1, Large());
+    BOOST_CHECK(isInline(slots, small));
+    BOOST_CHECK(!isInline(slots, large));  //放不下，在堆上
+    BOOST_CHECK_EQUAL(g_alive, 2);
+    slots.reset(0);
+    BOOST_CHECK_EQUAL(g_alive, 1);
+    slots.set(2, Small());
+    BOOST_CHECK_EQUAL(g_alive, 2);
+  }
+  BOOST_CHECK_EQUAL(g_alive, 0);
+
+  boost::shared_ptr<int> p(new int(1));
+  {
+    ContextSlots slots;
+    slots.set(ContextSlots::kCodecSlot, p);
+    BOOST_CHECK_EQUAL(p.use_count(), 2);
+  }
+  BOOST_CHECK_EQUAL(p.use_count(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testContextSlotsReuseInline)
+{
+  ContextSlots slots;
+  // 反复替换同一个slot不会耗尽内部内存
+  for (int i = 0; i < 100; ++i)
+  {
+    Small* small = slots.set(ContextSlots::kCodecSlot, Small());
+    BOOST_CHECK(isInline(slots, small));
+  }
+  Small* first = slots.set(0, Small());
+  Small* second = slots.set(1, Small());
+  BOOST_CHECK(isInline(slots, first));
+  BOOST_CHECK(isInline(slots, second));
+  BOOST_CHECK(!isInline(slots, slots.set(2, Small())));  //160字节放不下第三个
+  slots.reset(0);
+  slots.reset(1);
+  slots.reset(2);
+  BOOST_CHECK(isInline(slots, slots.set(3, Small())));  //都空了，从头开始
+  BOOST_CHECK_EQUAL(g_alive, 1);
+}
@@ -0,0 +1,91 @@
+#include <muduo/net/DelimiterSearch.h>
+
+//#define BOOST_TEST_MODULE DelimiterSearchTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+using namespace muduo::net;
+
+namespace
+{
+
+const char* naive(const char* begin, const char* end, const char* delim, size_t len)
+{
+  const char* found = std::search(begin, end, delim, delim + len);
+  return (found == end && len > 0) ? NULL : found;
+}
+
+std::vector<detail::FindDelimiterFunc> kernels()
+{
+  std::vector<detail::FindDelimiterFunc> result;
+  result.push_back(&detail::findDelimiterScalar);
+  result.push_back(&detail::findDelimiter);
+  if (detail::findDelimiterSse2())
+  {
+    result.push_back(detail::findDelimiterSse2());
+  }
+  if (detail::findDelimiterAvx2())
+  {
+    result.push_back(detail::findDelimiterAvx2());
+  }
+  return result;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testFindDelimiterSimple)
+{
+  const std::string text = "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n";
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  std::vector<detail::FindDelimiterFunc> all = kernels();
+  for (size_t k = 0; k < all.size(); ++k)
+  {
+    BOOST_CHECK_EQUAL(all[k](begin, end, "\r\n", 2) - begin, 14);
+    BOOST_CHECK_EQUAL(all[k](begin, end, "\r\n\r\n", 4) - begin, 33);
+    BOOST_CHECK_EQUAL(all[k](begin, end, ":", 1) - begin, 20);
+    BOOST_CHECK(all[k](begin, end, "\n\n", 2) == NULL);
+    BOOST_CHECK(all[k](begin, begin + 15, "\r\n", 2) == NULL);
+    BOOST_CHECK(all[k](begin, begin, "\r\n", 2) == NULL);
+  }
+}
+
+// 随机数据中只有少数几种字节，首末字节匹配而中间不匹配的情况很多
+BOOST_AUTO_TEST_CASE(testFindDelimiterRandom)
+{
+  const char kAlphabet[] = "\r\nab";
+  const char* delims[] = { "\n", "\r\n", "\r\r\n", "\r\n\r\n", "\ra\nb\r" };
+  std::vector<detail::FindDelimiterFunc> all = kernels();
+  srand(42);
+  for (int round = 0; round < 2000; ++round)
+  {
+    std::string text(rand() % 200, 'x');
+    int density = rand() % 64 + 1;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+      if (rand() % density == 0)
+      {
+        text[i] = kAlphabet[rand() % 4];
+      }
+    }
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (size_t d = 0; d < sizeof delims / sizeof delims[0]; ++d)
+    {
+      size_t len = strlen(delims[d]);
+      size_t offset = text.empty() ? 0 : rand() % text.size();
+      const char* expected = naive(begin + offset, end, delims[d], len);
+      for (size_t k = 0; k < all.size(); ++k)
+      {
+        BOOST_CHECK(all[k](begin + offset, end, delims[d], len) == expected);
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include <muduo/net/IdMap.h>
+
+//#define BOOST_TEST_MODULE IdMapTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <map>
+
+#include <stdlib.h>
+
+using muduo::net::IdMap;
+
+BOOST_AUTO_TEST_CASE(testIdMapInsertFindErase)
+{
+  IdMap<int> m;
+  BOOST_CHECK(m.empty());
+  BOOST_CHECK(m.insert(1, 10));
+  BOOST_CHECK(m.insert(2, 20));
+  BOOST_CHECK(!m.insert(1, 11));
+  BOOST_CHECK_EQUAL(m.size(), 2);
+  BOOST_CHECK_EQUAL(*m.find(1), 10);
+  BOOST_CHECK_EQUAL(*m.find(2), 20);
+  BOOST_CHECK(m.find(3) == NULL);
+  BOOST_CHECK(m.find(0) == NULL);
+  BOOST_CHECK(m.find(-1) == NULL);
+
+  BOOST_CHECK_EQUAL(m.erase(1), 1);
+  BOOST_CHECK_EQUAL(m.erase(1), 0);
+  BOOST_CHECK(m.find(1) == NULL);
+  BOOST_CHECK_EQUAL(*m.find(2), 20);
+  BOOST_CHECK_EQUAL(m.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(testIdMapGrow)
+{
+  IdMap<int64_t> m;
+  const int64_t kCount = 10000;
+  for (int64_t id = 1; id <= kCount; ++id)
+  {
+    BOOST_REQUIRE(m.insert(id, id * 3));
+  }
+  BOOST_CHECK_EQUAL(m.size(), kCount);
+  for (int64_t id = 1; id <= kCount; ++id)
+  {
+    BOOST_REQUIRE(m.find(id) != NULL);
+    BOOST_CHECK_EQUAL(*m.find(id), id * 3);
+  }
+  BOOST_CHECK(m.find(kCount + 1) == NULL);
+}
+
+BOOST_AUTO_TEST_CASE(testIdMapReleasesValues)
+{
+  boost::shared_ptr<int> p(new int(1));
+  IdMap<boost::shared_ptr<int> > m;
+  m.insert(1, p);
+  m.insert(2, p);
+  BOOST_CHECK_EQUAL(p.use_count(), 3);
+  m.erase(1);
+  BOOST_CHECK_EQUAL(p.use_count(), 2);
+
+  std::vector<boost::shared_ptr<int> > values;
+  m.takeAll(&values);
+  BOOST_CHECK(m.empty());
+  BOOST_CHECK(m.find(2) == NULL);
+  BOOST_CHECK_EQUAL(values.size(), 1);
+  BOOST_CHECK_EQUAL(p.use_count(), 2);
+}
+
+// 与std::map对照，随机插入删除，删除时往回挪的元素不能丢
+BOOST_AUTO_TEST_CASE(testIdMapRandom)
+{
+  IdMap<int64_t> m;
+  std::map<int64_t, int64_t> expected;
+  srand(42);
+  int64_t nextId = 1;
+  for (int i = 0; i < 200000; ++i)
+  {
+    if (rand() % 3 != 0 || expected.empty())
+    {
+      // 大多是连续的id，偶尔跳一大段，和TcpServer的用法相近
+      nextId += (rand() % 100 == 0) ? rand() : 1;
+      BOOST_REQUIRE(m.insert(nextId, i));
+      expected[nextId] = i;
+    }
+    else
+    {
+      int64_t id = nextId - rand() % 512;
+      BOOST_REQUIRE_EQUAL(m.erase(id), expected.erase(id));
+    }
+  }
+  BOOST_CHECK_EQUAL(m.size(), expected.size());
+  for (std::map<int64_t, int64_t>::iterator it = expected.begin();
+      it != expected.end(); ++it)
+  {
+    BOOST_REQUIRE(m.find(it->first) != NULL);
+    BOOST_CHECK_EQUAL(*m.find(it->first), it->second);
+  }
+}
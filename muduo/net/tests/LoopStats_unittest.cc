@@ -0,0 +1,124 @@
+#include <muduo/net/LoopStats.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThread.h>
+#include <muduo/base/CountDownLatch.h>
+
+//#define BOOST_TEST_MODULE LoopStatsTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <limits>
+
+#include <unistd.h>
+
+using muduo::CountDownLatch;
+using muduo::net::EventLoop;
+using muduo::net::EventLoopThread;
+using muduo::net::Histogram;
+using muduo::net::LoopStats;
+
+BOOST_AUTO_TEST_CASE(testHistogramBuckets)
+{
+  for (int64_t v = 0; v < 4; ++v)
+  {
+    BOOST_CHECK_EQUAL(Histogram::bucketOf(v), v);
+  }
+  // 每个2的幂分成4个桶，值总在自己的桶内
+  for (int64_t v = 4; v < (static_cast<int64_t>(1) << 30); v = v * 5 / 4 + 1)
+  {
+    int bucket = Histogram::bucketOf(v);
+    BOOST_CHECK_LE(v, Histogram::upperBoundOf(bucket));
+    BOOST_CHECK_GT(v, Histogram::upperBoundOf(bucket - 1));
+    BOOST_CHECK_LE(Histogram::upperBoundOf(bucket), v + v / 4);
+  }
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(-1), 0);
+  BOOST_CHECK_EQUAL(Histogram::bucketOf(std::numeric_limits<int64_t>::max()), Histogram::kNumBuckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(testHistogramPercentile)
+{
+  Histogram h;
+  BOOST_CHECK_EQUAL(h.percentile(99), 0);
+  for (int64_t v = 1; v <= 1000; ++v)
+  {
+    h.record(v);
+  }
+  BOOST_CHECK_EQUAL(h.count(), 1000);
+  BOOST_CHECK_EQUAL(h.sum(), 500500);
+  BOOST_CHECK_EQUAL(h.max(), 1000);
+  BOOST_CHECK_GE(h.percentile(50), 500);
+  BOOST_CHECK_LE(h.percentile(50), 625);
+  BOOST_CHECK_GE(h.percentile(99), 990);
+  BOOST_CHECK_EQUAL(h.percentile(100), 1000);
+
+  h.reset();
+  BOOST_CHECK_EQUAL(h.count(), 0);
+  BOOST_CHECK_EQUAL(h.max(), 0);
+}
+
+void count(int* n, LoopStats*)
+{
+  ++*n;
+}
+
+BOOST_AUTO_TEST_CASE(testLoopStats)
+{
+  int before = 0;
+  LoopStats::forEach(boost::bind(count, &before, _1));
+  {
+    LoopStats stats;
+    int n = 0;
+    LoopStats::forEach(boost::bind(count, &n, _1));
+    BOOST_CHECK_EQUAL(n, before + 1);
+
+    // 定时器的时间不重复算到timerfd的Channel上
+    stats.recordTimer("timer", 300);
+    stats.recordChannel(5, 400);
+    BOOST_CHECK_EQUAL(stats.timers().sum(), 300);
+    BOOST_CHECK_EQUAL(stats.channels().sum(), 100);
+    BOOST_CHECK_EQUAL(stats.maxCallbackMicroSeconds(), 300);
+    BOOST_CHECK_EQUAL(stats.maxCallbackKind(), LoopStats::kTimer);
+
+    stats.recordPendingFunctor("functor", 1000);
+    BOOST_CHECK_EQUAL(stats.maxCallbackKind(), LoopStats::kPendingFunctor);
+    BOOST_CHECK_EQUAL(stats.maxCallbackName(), "functor");
+
+    stats.reset();
+    BOOST_CHECK_EQUAL(stats.maxCallbackMicroSeconds(), 0);
+    BOOST_CHECK_EQUAL(stats.maxCallbackKind(), LoopStats::kNone);
+  }
+  int after = 0;
+  LoopStats::forEach(boost::bind(count, &after, _1));
+  BOOST_CHECK_EQUAL(after, before);
+}
+
+void slowFunctor(CountDownLatch* latch)
+{
+  ::usleep(50 * 1000);
+  latch->countDown();
+}
+
+// 别的线程调用reset()，由IO线程自己清零
+BOOST_AUTO_TEST_CASE(testResetFromOtherThread)
+{
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  LoopStats* stats = loop->stats();
+
+  CountDownLatch slow(1);
+  loop->runInLoop(boost::bind(slowFunctor, &slow));
+  slow.wait();
+  CountDownLatch recorded(1);  //slowFunctor返回之后才记录
+  loop->runInLoop(boost::bind(&CountDownLatch::countDown, &recorded));
+  recorded.wait();
+  BOOST_CHECK_GE(stats->maxCallbackMicroSeconds(), 50 * 1000);
+
+  stats->reset();
+  CountDownLatch done(1);
+  loop->runInLoop(boost::bind(&CountDownLatch::countDown, &done));  //排在清零之后
+  done.wait();
+  BOOST_CHECK_LT(stats->maxCallbackMicroSeconds(), 50 * 1000);
+}
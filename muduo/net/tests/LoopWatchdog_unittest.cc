@@ -0,0 +1,98 @@
+#include <muduo/net/LoopWatchdog.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThread.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Timestamp.h>
+
+//#define BOOST_TEST_MODULE LoopWatchdogTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+using muduo::CountDownLatch;
+using muduo::net::EventLoop;
+using muduo::net::EventLoopThread;
+using muduo::net::LoopWatchdog;
+
+namespace
+{
+
+void block(int milliSeconds, CountDownLatch* latch)
+{
+  //SIGURG会打断usleep()，睡够为止
+  muduo::Timestamp deadline(muduo::addTime(muduo::Timestamp::now(), milliSeconds / 1000.0));
+  while (muduo::Timestamp::now() < deadline)
+  {
+    ::usleep(1000);
+  }
+  latch->countDown();
+}
+
+// 在loop线程中卡住一段时间
+void runSlowCallback(int milliSeconds)
+{
+  EventLoopThread thread;
+  EventLoop* loop = thread.startLoop();
+  CountDownLatch latch(1);
+  loop->runInLoop(boost::bind(block, milliSeconds, &latch));
+  latch.wait();
+}
+
+void onUrgent(int)
+{
+}
+
+}
+
+// 前两个检查的是SIGURG原来的处理函数，放在装上onStackSignal之前
+BOOST_AUTO_TEST_CASE(testCaptureStackOff)
+{
+  LoopWatchdog watchdog(0.05);
+  watchdog.setCaptureStack(false);
+  watchdog.start();
+  runSlowCallback(300);
+  BOOST_CHECK_EQUAL(watchdog.numReports(), 1);
+  watchdog.stop();
+
+  struct sigaction old;
+  BOOST_REQUIRE_EQUAL(::sigaction(SIGURG, NULL, &old), 0);
+  BOOST_CHECK(old.sa_handler == SIG_DFL);
+}
+
+BOOST_AUTO_TEST_CASE(testKeepsOwnSignalHandler)
+{
+  struct sigaction sa;
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler = onUrgent;
+  ::sigemptyset(&sa.sa_mask);
+  BOOST_REQUIRE_EQUAL(::sigaction(SIGURG, &sa, NULL), 0);
+
+  LoopWatchdog watchdog(0.05);
+  watchdog.start();
+  runSlowCallback(300);
+  BOOST_CHECK_EQUAL(watchdog.numReports(), 1);  //没有调用栈也照样报告
+  watchdog.stop();
+
+  struct sigaction old;
+  BOOST_REQUIRE_EQUAL(::sigaction(SIGURG, NULL, &old), 0);
+  BOOST_CHECK(old.sa_handler == onUrgent);
+  sa.sa_handler = SIG_DFL;
+  ::sigaction(SIGURG, &sa, NULL);
+}
+
+BOOST_AUTO_TEST_CASE(testSlowCallbackReported)
+{
+  LoopWatchdog watchdog(0.05);
+  watchdog.start();
+  runSlowCallback(10);
+  BOOST_CHECK_EQUAL(watchdog.numReports(), 0);
+  runSlowCallback(300);
+  BOOST_CHECK_EQUAL(watchdog.numReports(), 1);  //同一个回调只报告一次
+  watchdog.stop();
+}
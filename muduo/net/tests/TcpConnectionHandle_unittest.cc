@@ -0,0 +1,120 @@
+#include <muduo/net/TcpConnection.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/base/Thread.h>
+
+//#define BOOST_TEST_MODULE TcpConnectionHandleTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using muduo::Thread;
+using muduo::net::EventLoop;
+using muduo::net::InetAddress;
+using muduo::net::TcpConnection;
+using muduo::net::TcpConnectionHandle;
+using muduo::net::TcpConnectionPtr;
+
+namespace
+{
+
+// TcpConnection析构时关闭fd
+bool isOpen(int fd)
+{
+  return ::fcntl(fd, F_GETFD) != -1;
+}
+
+struct Fixture
+{
+  Fixture()
+  {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    sockfd = fds[0];
+    peerfd = fds[1];
+    conn = TcpConnection::create(&loop, "conn", sockfd, InetAddress(), InetAddress());
+    conn->setConnectionCallback(muduo::net::defaultConnectionCallback);
+    conn->connectEstablished();
+  }
+
+  ~Fixture()
+  {
+    ::close(peerfd);
+  }
+
+  // 之后只剩handle持有连接
+  void destroyConnection()
+  {
+    conn->connectDestroyed();
+    conn.reset();
+  }
+
+  EventLoop loop;
+  int sockfd;
+  int peerfd;
+  TcpConnectionPtr conn;
+};
+
+void assign(TcpConnectionHandle* to, const TcpConnectionHandle* from)
+{
+  *to = *from;
+}
+
+void runInThread(const Thread::ThreadFunc& func)
+{
+  Thread thread(func);
+  thread.start();
+  thread.join();
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE(testHandleOutlivesSharedPtr, Fixture)
+{
+  TcpConnectionHandle handle(conn);
+  TcpConnectionHandle copy(handle);
+  BOOST_CHECK(copy);
+  BOOST_CHECK_EQUAL(copy.get(), conn.get());
+  BOOST_CHECK_EQUAL(conn.use_count(), 1);  //handle不增加shared_ptr的计数
+
+  destroyConnection();
+  BOOST_CHECK(isOpen(sockfd));
+  BOOST_CHECK_EQUAL(handle->name(), "conn");
+
+  handle.reset();
+  BOOST_CHECK(!handle);
+  BOOST_CHECK(isOpen(sockfd));
+  copy.reset();  //最后一个引用，析构连接
+  BOOST_CHECK(!isOpen(sockfd));
+}
+
+BOOST_FIXTURE_TEST_CASE(testLoopRefReleasedInOtherThread, Fixture)
+{
+  TcpConnectionHandle handle(conn);  //loop线程中的引用
+  destroyConnection();
+
+  runInThread(boost::bind(&TcpConnectionHandle::reset, &handle));
+  BOOST_CHECK(isOpen(sockfd));  //转回loop线程释放
+  loop.runAfter(0.01, boost::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  BOOST_CHECK(!isOpen(sockfd));
+}
+
+BOOST_FIXTURE_TEST_CASE(testHandleCopiedInOtherThread, Fixture)
+{
+  TcpConnectionHandle inLoop(conn);
+  TcpConnectionHandle other;
+  runInThread(boost::bind(&assign, &other, &inLoop));  //原子引用
+  BOOST_CHECK_EQUAL(other.get(), conn.get());
+
+  destroyConnection();
+  inLoop.reset();
+  BOOST_CHECK(isOpen(sockfd));
+  runInThread(boost::bind(&TcpConnectionHandle::reset, &other));
+  BOOST_CHECK(!isOpen(sockfd));  //在其他线程中析构
+}
@@ -0,0 +1,408 @@
+#include <muduo/net/TcpConnection.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/IdleConnectionList.h>
+#include <muduo/base/Thread.h>
+
+//#define BOOST_TEST_MODULE TcpConnectionTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <vector>
+
+using muduo::string;
+using muduo::Thread;
+using muduo::Timestamp;
+using muduo::net::Buffer;
+using muduo::net::EventLoop;
+using muduo::net::IdleConnectionList;
+using muduo::net::InetAddress;
+using muduo::net::TcpConnection;
+using muduo::net::TcpConnectionPtr;
+
+namespace
+{
+
+int g_writeCompleted = 0;
+
+void onWriteComplete(const TcpConnectionPtr&)
+{
+  ++g_writeCompleted;
+}
+
+void onClose(const TcpConnectionPtr&)
+{
+}
+
+std::vector<string> g_lines;
+const Buffer* g_lastBuffer = NULL;
+
+// 只取走完整的行，半行留在buf中
+void onLine(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  g_lastBuffer = buf;
+  const char* eol = NULL;
+  while ((eol = buf->findEOL()) != NULL)
+  {
+    g_lines.push_back(string(buf->peek(), eol));
+    buf->retrieveUntil(eol + 1);
+  }
+}
+
+// 什么都不取
+void onMessageKeep(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  g_lastBuffer = buf;
+}
+
+void writePeer(int peerfd, const char* data)
+{
+  size_t len = ::strlen(data);
+  BOOST_REQUIRE_EQUAL(::write(peerfd, data, len), static_cast<ssize_t>(len));
+}
+
+void runInThread(const Thread::ThreadFunc& func)
+{
+  Thread thread(func);
+  thread.start();
+  thread.join();
+}
+
+// 一个socketpair，一端是TcpConnection
+struct Fixture
+{
+  Fixture()
+  {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    sockfd = fds[0];
+    peerfd = fds[1];
+    conn = TcpConnection::create(&loop, "conn", sockfd, InetAddress(), InetAddress());
+    conn->setConnectionCallback(muduo::net::defaultConnectionCallback);
+    conn->setMessageCallback(muduo::net::defaultMessageCallback);
+    conn->setCloseCallback(onClose);
+    g_writeCompleted = 0;
+    g_lines.clear();
+    g_lastBuffer = NULL;
+  }
+
+  ~Fixture()
+  {
+    if (conn)
+    {
+      conn->connectDestroyed();
+    }
+    if (peerfd >= 0)
+    {
+      ::close(peerfd);
+    }
+    for (size_t i = 0; i < others.size(); ++i)
+    {
+      others[i]->connectDestroyed();
+      ::close(otherPeers[i]);
+    }
+  }
+
+  // 同一个loop上的另一个连接，还没有connectEstablished()
+  TcpConnectionPtr newConnection(int* otherPeer)
+  {
+    int fds[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds), 0);
+    TcpConnectionPtr other = TcpConnection::create(&loop, "other", fds[0], InetAddress(), InetAddress());
+    other->setConnectionCallback(muduo::net::defaultConnectionCallback);
+    other->setMessageCallback(muduo::net::defaultMessageCallback);
+    other->setCloseCallback(onClose);
+    others.push_back(other);
+    otherPeers.push_back(fds[1]);
+    *otherPeer = fds[1];
+    return other;
+  }
+
+  // 对端关闭，handleClose()之后连接是kDisconnected
+  void closePeer()
+  {
+    ::close(peerfd);
+    peerfd = -1;
+    runFor(0.01);
+    BOOST_CHECK(conn->disconnected());
+  }
+
+  void runFor(double seconds)
+  {
+    loop.runAfter(seconds, boost::bind(&EventLoop::quit, &loop));
+    loop.loop();
+  }
+
+  // 读到EOF为止，没有EOF时返回"<no eof>"
+  string readPeer()
+  {
+    string result;
+    char buf[4096];
+    ssize_t n = 0;
+    while ((n = ::read(peerfd, buf, sizeof buf)) > 0)
+    {
+      result.append(buf, n);
+    }
+    return n == 0 ? result : "<no eof>";
+  }
+
+  EventLoop loop;
+  int sockfd;
+  int peerfd;
+  TcpConnectionPtr conn;
+  std::vector<TcpConnectionPtr> others;
+  std::vector<int> otherPeers;
+};
+
+// 100字节的临时文件，已经unlink
+int makeFile()
+{
+  char name[] = "/tmp/tcpconnection_unittest_XXXXXX";
+  int fd = ::mkstemp(name);
+  BOOST_REQUIRE(fd >= 0);
+  ::unlink(name);
+  string content(100, 'f');
+  BOOST_REQUIRE_EQUAL(::write(fd, content.data(), content.size()), 100);
+  return fd;
+}
+
+int countOpenFds()
+{
+  int count = 0;
+  DIR* dir = ::opendir("/proc/self/fd");
+  while (dir && ::readdir(dir))
+  {
+    ++count;
+  }
+  if (dir)
+  {
+    ::closedir(dir);
+  }
+  return count;
+}
+
+// 别的线程里依次调用，这几个任务按顺序排在loop的队列中
+void sendFileAndShutdown(const TcpConnectionPtr& conn, int fd)
+{
+  conn->sendFile(fd, 0, 100);
+  conn->send("tail");
+  conn->shutdown();
+}
+
+void sendFileTruncated(bool edgeTriggered)
+{
+  Fixture f;
+  f.conn->setEdgeTriggered(edgeTriggered);
+  f.conn->setWriteCompleteCallback(onWriteComplete);
+  f.conn->connectEstablished();
+  int filefd = makeFile();
+  runInThread(boost::bind(sendFileAndShutdown, f.conn, filefd));
+  BOOST_REQUIRE_EQUAL(::ftruncate(filefd, 40), 0);  //sendFile()已经排队，sendfile(2)还没调用
+  ::close(filefd);
+  f.runFor(0.1);
+
+  // 文件剩下的60字节丢弃，后面的数据照发，发完之后关闭写端
+  BOOST_CHECK_EQUAL(f.readPeer(), string(40, 'f') + "tail");
+  //ET模式下文件和"tail"各自直接发完，各有一次回调
+  BOOST_CHECK_EQUAL(g_writeCompleted, f.conn->edgeTriggered() ? 2 : 1);
+  f.closePeer();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(testSendFileTruncated)
+{
+  sendFileTruncated(false);
+}
+
+BOOST_AUTO_TEST_CASE(testSendFileTruncatedEdgeTriggered)
+{
+  sendFileTruncated(true);
+}
+
+// 别的线程调用sendFile()，任务还没执行loop就析构了，dup出来的fd不能泄漏
+BOOST_AUTO_TEST_CASE(testSendFileDroppedTask)
+{
+  int filefd = makeFile();
+  int before = countOpenFds();
+  {
+    Fixture f;
+    f.conn->connectEstablished();
+    int connected = countOpenFds();
+    runInThread(boost::bind(&TcpConnection::sendFile, get_pointer(f.conn), filefd, 0, 100));
+    BOOST_CHECK_EQUAL(countOpenFds(), connected + 1);  //dup出来的fd
+    f.conn->connectDestroyed();
+    f.conn.reset();  //sendFileInLoop()还在pending队列中，没有机会执行
+  }
+  BOOST_CHECK_EQUAL(countOpenFds(), before);
+  ::close(filefd);
+}
+
+// 一行分两次到达：第一次读到共享Buffer，半行移到连接自己的inputBuffer()
+BOOST_AUTO_TEST_CASE(testSharedReadBufferSplitMessage)
+{
+  Fixture f;
+  f.conn->setSharedReadBuffer(true);
+  f.conn->setMessageCallback(onLine);
+  f.conn->connectEstablished();
+
+  writePeer(f.peerfd, "hello ");
+  f.runFor(0.01);
+  BOOST_CHECK(g_lastBuffer == f.loop.sharedReadBuffer());
+  BOOST_CHECK(g_lines.empty());
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->toStringPiece().as_string(), "hello ");
+  BOOST_CHECK_EQUAL(f.loop.sharedReadBuffer()->readableBytes(), 0);
+
+  // inputBuffer()非空，接着读到它后面
+  writePeer(f.peerfd, "world\nnext\n");
+  f.runFor(0.01);
+  BOOST_CHECK(g_lastBuffer == f.conn->inputBuffer());
+  BOOST_REQUIRE_EQUAL(g_lines.size(), 2);
+  BOOST_CHECK_EQUAL(g_lines[0], "hello world");
+  BOOST_CHECK_EQUAL(g_lines[1], "next");
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->readableBytes(), 0);
+
+  // 又回到共享Buffer
+  writePeer(f.peerfd, "last\n");
+  f.runFor(0.01);
+  BOOST_CHECK(g_lastBuffer == f.loop.sharedReadBuffer());
+  BOOST_REQUIRE_EQUAL(g_lines.size(), 3);
+  BOOST_CHECK_EQUAL(g_lines[2], "last");
+  f.closePeer();
+}
+
+// 回调一个字节都不取，数据全部留给连接自己
+BOOST_AUTO_TEST_CASE(testSharedReadBufferLeavesUnread)
+{
+  Fixture f;
+  int otherPeer = -1;
+  TcpConnectionPtr other = f.newConnection(&otherPeer);
+  f.conn->setSharedReadBuffer(true);
+  f.conn->setMessageCallback(onMessageKeep);
+  other->setSharedReadBuffer(true);
+  other->setMessageCallback(onLine);
+  f.conn->connectEstablished();
+  other->connectEstablished();
+
+  writePeer(f.peerfd, "abc");
+  f.runFor(0.01);
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->toStringPiece().as_string(), "abc");
+  BOOST_CHECK_EQUAL(f.loop.sharedReadBuffer()->readableBytes(), 0);
+
+  // 共享Buffer已经空了，别的连接可以用
+  writePeer(otherPeer, "line\n");
+  f.runFor(0.01);
+  BOOST_CHECK(g_lastBuffer == f.loop.sharedReadBuffer());
+  BOOST_REQUIRE_EQUAL(g_lines.size(), 1);
+  BOOST_CHECK_EQUAL(g_lines[0], "line");
+
+  writePeer(f.peerfd, "def");
+  f.runFor(0.01);
+  BOOST_CHECK(g_lastBuffer == f.conn->inputBuffer());
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->toStringPiece().as_string(), "abcdef");
+  f.closePeer();
+}
+
+// 只释放空闲连接的空Buffer：有数据的Buffer保留数据，活跃的连接不动
+BOOST_AUTO_TEST_CASE(testReleaseIdleBuffers)
+{
+  Fixture f;
+  boost::shared_ptr<IdleConnectionList> idleList =
+      boost::make_shared<IdleConnectionList>(&f.loop, 0.0, 0.05);
+  idleList->start();
+
+  int pendingPeer = -1;
+  TcpConnectionPtr pending = f.newConnection(&pendingPeer);
+  pending->setMessageCallback(onMessageKeep);
+  int activePeer = -1;
+  TcpConnectionPtr active = f.newConnection(&activePeer);
+  f.conn->setIdleList(idleList);
+  pending->setIdleList(idleList);
+  active->setIdleList(idleList);
+  f.conn->connectEstablished();
+  pending->connectEstablished();
+  active->connectEstablished();
+
+  // pending：没取走的输入和对端不读而积压的输出
+  writePeer(pendingPeer, "half");
+  pending->send(string(1024 * 1024, 'x'));
+  size_t pendingOutput = pending->outputBuffer()->readableBytes();
+  BOOST_REQUIRE(pendingOutput > 0);
+  writePeer(f.peerfd, "x");  //Buffer第一次用到时才分配
+  f.runFor(0.01);
+  BOOST_CHECK(f.conn->inputBuffer()->internalCapacity() > 0);
+
+  // active一直有数据来
+  f.loop.runEvery(0.01, boost::bind(writePeer, activePeer, "a"));
+  f.runFor(0.3);
+
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(f.conn->outputBuffer()->internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(pending->inputBuffer()->toStringPiece().as_string(), "half");
+  BOOST_CHECK_EQUAL(pending->outputBuffer()->readableBytes(), pendingOutput);
+  BOOST_CHECK(active->inputBuffer()->internalCapacity() > 0);
+  idleList->stop();
+  f.closePeer();
+}
+
+// 释放过Buffer的连接再收到数据时重新分配
+BOOST_AUTO_TEST_CASE(testReadAfterRelease)
+{
+  Fixture f;
+  boost::shared_ptr<IdleConnectionList> idleList =
+      boost::make_shared<IdleConnectionList>(&f.loop, 0.0, 0.02);
+  idleList->start();
+  f.conn->setIdleList(idleList);
+  f.conn->setMessageCallback(onLine);
+  f.conn->connectEstablished();
+  f.runFor(0.1);
+  BOOST_REQUIRE_EQUAL(f.conn->inputBuffer()->internalCapacity(), 0);
+
+  writePeer(f.peerfd, "again\n");
+  f.runFor(0.01);
+  BOOST_REQUIRE_EQUAL(g_lines.size(), 1);
+  BOOST_CHECK_EQUAL(g_lines[0], "again");
+  BOOST_CHECK(f.conn->inputBuffer()->internalCapacity() > 0);
+
+  // 发送也一样
+  f.conn->send("reply");
+  char buf[16];
+  BOOST_CHECK_EQUAL(::read(f.peerfd, buf, sizeof buf), 5);
+  idleList->stop();
+  f.closePeer();
+}
+
+// 唯一的连接总是链表尾，有数据之后再空闲还要能再次释放
+BOOST_AUTO_TEST_CASE(testReleaseAgainAfterTraffic)
+{
+  Fixture f;
+  boost::shared_ptr<IdleConnectionList> idleList =
+      boost::make_shared<IdleConnectionList>(&f.loop, 0.0, 0.02);
+  idleList->start();
+  f.conn->setIdleList(idleList);
+  f.conn->setMessageCallback(onLine);
+  f.conn->connectEstablished();
+  for (int i = 0; i < 3; ++i)
+  {
+    f.runFor(0.1);
+    BOOST_REQUIRE_EQUAL(f.conn->inputBuffer()->internalCapacity(), 0);
+    writePeer(f.peerfd, "ping\n");
+    f.runFor(0.005);
+    BOOST_CHECK(f.conn->inputBuffer()->internalCapacity() > 0);
+  }
+  f.runFor(0.1);
+  BOOST_CHECK_EQUAL(f.conn->inputBuffer()->internalCapacity(), 0);
+  BOOST_CHECK_EQUAL(g_lines.size(), 3);
+  idleList->stop();
+  f.closePeer();
+}
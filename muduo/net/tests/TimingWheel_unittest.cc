@@ -0,0 +1,109 @@
+#include <muduo/net/TimingWheel.h>
+#include <muduo/net/Timer.h>
+
+//#define BOOST_TEST_MODULE TimingWheelTest
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include <boost/bind.hpp>
+
+#include <vector>
+
+using muduo::Timestamp;
+using muduo::addTime;
+using muduo::net::Timer;
+using muduo::net::TimingWheel;
+
+namespace
+{
+void noop()
+{
+}
+
+Timer* newTimer(Timestamp when)
+{
+  return new Timer(boost::bind(noop), when, 0.0);
+}
+
+void deleteAll(std::vector<Timer*>* timers)
+{
+  for (size_t i = 0; i < timers->size(); ++i)
+  {
+    delete (*timers)[i];
+  }
+  timers->clear();
+}
+}
+
+BOOST_AUTO_TEST_CASE(testTimingWheelExpire)
+{
+  const Timestamp start(Timestamp::now());
+  TimingWheel wheel(0.1, 8, start);
+  BOOST_CHECK(wheel.empty());
+
+  Timer* t1 = newTimer(addTime(start, 0.25));
+  Timer* t2 = newTimer(addTime(start, 0.55));
+  Timer* t3 = newTimer(addTime(start, 2.0));  // more than one round
+  wheel.insert(t1);
+  wheel.insert(t2);
+  wheel.insert(t3);
+  BOOST_CHECK_EQUAL(wheel.size(), 3);
+
+  std::vector<Timer*> expired;
+  wheel.getExpired(addTime(start, 0.2), &expired);
+  BOOST_CHECK(expired.empty());
+
+  wheel.getExpired(addTime(start, 0.3), &expired);  // never early, never more than a tick late
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], t1);
+  deleteAll(&expired);
+
+  wheel.getExpired(addTime(start, 1.5), &expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], t2);
+  deleteAll(&expired);
+  BOOST_CHECK_EQUAL(wheel.size(), 1);
+
+  wheel.getExpired(addTime(start, 2.05), &expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], t3);
+  deleteAll(&expired);
+  BOOST_CHECK(wheel.empty());
+}
+
+BOOST_AUTO_TEST_CASE(testTimingWheelCancel)
+{
+  const Timestamp start(Timestamp::now());
+  TimingWheel wheel(0.1, 8, start);
+
+  Timer* t1 = newTimer(addTime(start, 0.5));
+  Timer* t2 = newTimer(addTime(start, 0.5));
+  Timer* t3 = newTimer(addTime(start, 0.5));
+  const int64_t seq2 = t2->sequence();
+  wheel.insert(t1);
+  wheel.insert(t2);
+  wheel.insert(t3);
+
+  BOOST_CHECK(wheel.cancel(t2, seq2));
+  BOOST_CHECK(!wheel.cancel(t2, seq2));
+  BOOST_CHECK_EQUAL(wheel.size(), 2);
+
+  std::vector<Timer*> expired;
+  wheel.getExpired(addTime(start, 10.0), &expired);  // long stall, whole wheel scanned
+  BOOST_CHECK_EQUAL(expired.size(), 2);
+  BOOST_CHECK(!wheel.cancel(t1, t1->sequence()));
+  deleteAll(&expired);
+
+  // expired already, goes to the next tick
+  Timer* t4 = newTimer(addTime(start, 1.0));
+  wheel.insert(t4);
+  wheel.getExpired(addTime(start, 10.0), &expired);
+  BOOST_CHECK(expired.empty());
+  wheel.getExpired(addTime(start, 10.1), &expired);
+  BOOST_REQUIRE_EQUAL(expired.size(), 1);
+  BOOST_CHECK_EQUAL(expired[0], t4);
+  deleteAll(&expired);
+
+  wheel.insert(newTimer(addTime(start, 20.0)));  // deleted by ~TimingWheel
+}